@@ -0,0 +1,274 @@
+/**
+ * Measures the read and write performance of an M24C64, and of a bank of two of them when a second one is present.
+ * @note The content of the eeproms is overwritten.
+ * @note Results are printed one per line as: result,<name>,<value>,<unit>
+ * @note Lines starting with "meta" describe the setup the results were taken with, and lines starting with "#" are comments.
+ */
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Wire.h>
+
+/* Project code */
+#include <eeprom_i2c_bank.h>
+#include <m24c64.h>
+
+/* Configuration */
+#define BENCHMARK_LIBRARY_VERSION "0.1.0"  // Keep in sync with library.properties
+#define BENCHMARK_SERIAL_SPEED 115200
+#define BENCHMARK_I2C_CLOCK 400000
+#define BENCHMARK_I2C_ADDRESS_0 0x50
+#define BENCHMARK_I2C_ADDRESS_1 0x51
+#define BENCHMARK_LENGTH 1024
+#define BENCHMARK_WRITE_CYCLE_SAMPLES 32
+
+/* Devices */
+static m24c64 m_eeprom;
+static eeprom_i2c_bank<eeprom_i2c_m24c64, 2> m_bank;
+static uint8_t m_read_ahead[64];
+
+/* Scratch buffers */
+static uint8_t m_data[BENCHMARK_LENGTH];
+static uint8_t m_check[BENCHMARK_LENGTH];
+
+/**
+ * Prints a single result.
+ * @param[in] name The name of the measure.
+ * @param[in] value The measured value.
+ * @param[in] unit The unit of the value.
+ */
+static void result(const char* name, const uint32_t value, const char* unit) {
+    Serial.print("result,");
+    Serial.print(name);
+    Serial.print(",");
+    Serial.print(value);
+    Serial.print(",");
+    Serial.println(unit);
+}
+
+/**
+ * Prints a throughput result, computed from a number of bytes and a duration.
+ * @param[in] name The name of the measure.
+ * @param[in] length The number of bytes transferred.
+ * @param[in] duration The duration of the transfer, in microseconds.
+ */
+static void result_throughput(const char* name, const uint32_t length, const uint32_t duration) {
+    result(name, (duration > 0) ? (uint32_t)((uint64_t)length * 1000000UL / duration) : 0, "B/s");
+}
+
+/**
+ * Prints a comment, for when a measure can't be taken.
+ * @param[in] text The comment.
+ */
+static void comment(const char* text) {
+    Serial.print("# ");
+    Serial.println(text);
+}
+
+/**
+ * Generates a pseudo random number, identical from one run to another.
+ * @return The number.
+ */
+static uint32_t random_next(void) {
+    static uint32_t state = 12345;
+    state = state * 1103515245UL + 12345UL;
+    return state >> 8;
+}
+
+/**
+ * Measures writes of the same range either one byte per call, aligned on pages, or unaligned.
+ */
+static void benchmark_write(void) {
+    uint32_t start;
+    int res;
+
+    /* One byte per call, each one costing a write cycle */
+    start = micros();
+    for (size_t i = 0; i < 64; i++) {
+        if (m_eeprom.write(i, &m_data[i], 1) != 1) {
+            comment("write_byte failed");
+            return;
+        }
+    }
+    m_eeprom.flush();
+    result_throughput("write_byte", 64, micros() - start);
+
+    /* Page aligned range */
+    start = micros();
+    res = m_eeprom.write(0, m_data, BENCHMARK_LENGTH);
+    m_eeprom.read(0, m_check, 1);  // Wait for the last write cycle
+    result_throughput("write_page", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("write_page failed");
+
+    /* Unaligned range, with a partial page at both ends */
+    start = micros();
+    res = m_eeprom.write(m24c64::size_page() / 2 + 1, m_data, BENCHMARK_LENGTH);
+    m_eeprom.read(0, m_check, 1);
+    result_throughput("write_unaligned", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("write_unaligned failed");
+}
+
+/**
+ * Measures a large sequential read, and many small reads at random addresses.
+ */
+static void benchmark_read(void) {
+    uint32_t start;
+    int res;
+
+    /* Sequential */
+    start = micros();
+    res = m_eeprom.read(0, m_check, BENCHMARK_LENGTH);
+    result_throughput("read_sequential", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("read_sequential failed");
+
+    /* Random, 4 bytes at a time */
+    start = micros();
+    for (size_t i = 0; i < BENCHMARK_LENGTH; i += 4) {
+        uint32_t address = random_next() % (m24c64::size_total() - 4);
+        if (m_eeprom.read(address, &m_check[i], 4) != 4) {
+            comment("read_random failed");
+            return;
+        }
+    }
+    result_throughput("read_random_4", BENCHMARK_LENGTH, micros() - start);
+}
+
+/**
+ * Measures the cost of reading bytes one at a time through the stream interface, without and with a read ahead buffer.
+ */
+static void benchmark_stream(void) {
+    uint32_t start;
+
+    /* Without read ahead buffer */
+    m_eeprom.setup(Wire, BENCHMARK_I2C_ADDRESS_0);
+    m_eeprom.seek_read(0);
+    start = micros();
+    for (size_t i = 0; i < 256; i++) {
+        m_eeprom.read();
+    }
+    result("stream_read_byte", (micros() - start) / 256, "us");
+
+    /* With read ahead buffer */
+    m_eeprom.setup(Wire, BENCHMARK_I2C_ADDRESS_0, m_read_ahead, sizeof(m_read_ahead));
+    m_eeprom.seek_read(0);
+    start = micros();
+    for (size_t i = 0; i < 256; i++) {
+        m_eeprom.read();
+    }
+    result("stream_read_byte_buffered", (micros() - start) / 256, "us");
+}
+
+/**
+ * Measures the distribution of the time the device takes to complete its internal write cycle, by polling it until it acknowledges.
+ */
+static void benchmark_write_cycle(void) {
+    uint32_t samples[BENCHMARK_WRITE_CYCLE_SAMPLES];
+
+    /* Take samples */
+    for (size_t i = 0; i < BENCHMARK_WRITE_CYCLE_SAMPLES; i++) {
+        uint32_t address = (random_next() % (m24c64::size_total() / m24c64::size_page())) * m24c64::size_page();
+        if (m_eeprom.write(address, m_data, m24c64::size_page()) != m24c64::size_page()) {
+            comment("write_cycle failed");
+            return;
+        }
+        uint32_t start = micros();
+        while (m_eeprom.detect() == false && micros() - start < 20000) {
+        }
+        samples[i] = micros() - start;
+    }
+
+    /* Sort them */
+    for (size_t i = 1; i < BENCHMARK_WRITE_CYCLE_SAMPLES; i++) {
+        uint32_t sample = samples[i];
+        size_t j = i;
+        for (; j > 0 && samples[j - 1] > sample; j--) {
+            samples[j] = samples[j - 1];
+        }
+        samples[j] = sample;
+    }
+
+    /* Print distribution */
+    result("write_cycle_min", samples[0], "us");
+    result("write_cycle_p50", samples[BENCHMARK_WRITE_CYCLE_SAMPLES / 2], "us");
+    result("write_cycle_p90", samples[(BENCHMARK_WRITE_CYCLE_SAMPLES * 9) / 10], "us");
+    result("write_cycle_max", samples[BENCHMARK_WRITE_CYCLE_SAMPLES - 1], "us");
+}
+
+/**
+ * Measures sequential writes to two devices, concatenated then interleaved.
+ */
+static void benchmark_bank(void) {
+    const uint8_t addresses[2] = {BENCHMARK_I2C_ADDRESS_0, BENCHMARK_I2C_ADDRESS_1};
+    uint32_t start;
+    int res;
+
+    /* Concatenated: a sequential write keeps a single device busy */
+    m_bank.setup(Wire, addresses, false);
+    if (m_bank.detect() == false) {
+        comment("second device not found, skipping bank measures");
+        return;
+    }
+    start = micros();
+    res = m_bank.write(0, m_data, BENCHMARK_LENGTH);
+    m_bank.read(0, m_check, 1);
+    m_bank.read(m24c64::size_total(), m_check, 1);
+    result_throughput("bank_write_concatenated", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("bank_write_concatenated failed");
+
+    /* Interleaved: consecutive pages go to both devices, whose write cycles overlap */
+    m_bank.setup(Wire, addresses, true);
+    start = micros();
+    res = m_bank.write(0, m_data, BENCHMARK_LENGTH);
+    m_bank.read(0, m_check, 1);
+    m_bank.read(m24c64::size_page(), m_check, 1);
+    result_throughput("bank_write_interleaved", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("bank_write_interleaved failed");
+
+    /* Sequential read of the interleaved bank */
+    start = micros();
+    res = m_bank.read(0, m_check, BENCHMARK_LENGTH);
+    result_throughput("bank_read_interleaved", BENCHMARK_LENGTH, micros() - start);
+    if (res != BENCHMARK_LENGTH) comment("bank_read_interleaved failed");
+}
+
+void setup(void) {
+
+    /* Setup serial and i2c */
+    Serial.begin(BENCHMARK_SERIAL_SPEED);
+    while (!Serial) {
+    }
+    Wire.begin();
+    Wire.setClock(BENCHMARK_I2C_CLOCK);
+
+    /* Describe setup */
+    Serial.println("meta,library," BENCHMARK_LIBRARY_VERSION);
+#if defined(ARDUINO_BOARD)
+    Serial.println("meta,board," ARDUINO_BOARD);
+#endif
+    Serial.print("meta,cpu_frequency,");
+    Serial.println(F_CPU);
+    Serial.print("meta,i2c_clock,");
+    Serial.println(BENCHMARK_I2C_CLOCK);
+    Serial.print("meta,i2c_buffer,");
+    Serial.println(I2C_BUFFER_SIZE);
+
+    /* Setup eeprom */
+    if (m_eeprom.setup(Wire, BENCHMARK_I2C_ADDRESS_0) < 0 || m_eeprom.detect() == false) {
+        comment("device not found");
+        return;
+    }
+    for (size_t i = 0; i < BENCHMARK_LENGTH; i++) {
+        m_data[i] = random_next();
+    }
+
+    /* Run benchmarks */
+    benchmark_write();
+    benchmark_read();
+    benchmark_stream();
+    benchmark_write_cycle();
+    benchmark_bank();
+    comment("done");
+}
+
+void loop(void) {
+}
@@ -0,0 +1,65 @@
+/**
+ * Measures the flash and ram cost of the driver, with or without the stream interface.
+ * @note Build it twice, with FOOTPRINT_STREAM set to 0 then 1, and compare the flash and ram use reported by the compiler. Building it with FOOTPRINT_DRIVER set to 0 gives the cost of the sketch alone.
+ * @note Building it with FOOTPRINT_SLIM set to 1 gives the cost of the slim profile, without the optional features of the core. The library being made of headers only, the define in the sketch is enough.
+ * @note Results are printed one per line as: result,<name>,<value>,<unit>
+ */
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Wire.h>
+
+/* Configuration */
+#define FOOTPRINT_SERIAL_SPEED 115200
+#define FOOTPRINT_I2C_ADDRESS 0x50
+#ifndef FOOTPRINT_DRIVER
+#define FOOTPRINT_DRIVER 1
+#endif
+#ifndef FOOTPRINT_STREAM
+#define FOOTPRINT_STREAM 0
+#endif
+#ifndef FOOTPRINT_SLIM
+#define FOOTPRINT_SLIM 0
+#endif
+#if FOOTPRINT_SLIM
+#define EEPROM_I2C_SLIM
+#endif
+
+/* Project code */
+#include <m24c64.h>
+
+/* Device */
+#if FOOTPRINT_DRIVER && FOOTPRINT_STREAM
+static m24c64 m_eeprom;
+#elif FOOTPRINT_DRIVER
+static m24c64_core m_eeprom;
+#endif
+
+void setup(void) {
+    uint8_t data[4] = {0};
+
+    /* Setup serial and i2c */
+    Serial.begin(FOOTPRINT_SERIAL_SPEED);
+    while (!Serial) {
+    }
+    Wire.begin();
+
+    /* Print the ram used by an instance */
+#if FOOTPRINT_DRIVER
+    Serial.print("result,instance,");
+    Serial.print((uint32_t)sizeof(m_eeprom));
+    Serial.println(",B");
+
+    /* Use the functions a small application needs, so that they are part of the measure */
+    m_eeprom.setup(Wire, FOOTPRINT_I2C_ADDRESS);
+    m_eeprom.read(0, data, sizeof(data));
+    data[0]++;
+    m_eeprom.write(0, data, sizeof(data));
+#endif
+    Serial.print("result,data,");
+    Serial.print(data[0]);
+    Serial.println(",");
+}
+
+void loop(void) {
+}
@@ -0,0 +1,90 @@
+/**
+ * Compares write and read strategies on a simulated M24C64, without any eeprom connected.
+ * @note The simulated device lives in ram, and counts the transactions, write cycles and bus time of each operation.
+ * @note Results are printed one per line as: result,<name>,<transactions>,<write cycles>,<bus time in us>
+ */
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* Project code */
+#include <eeprom_i2c.h>
+#include <eeprom_i2c_sim.h>
+
+/* Configuration */
+#define SIMULATOR_SERIAL_SPEED 115200
+#define SIMULATOR_I2C_ADDRESS 0x50
+
+/* Simulated device, reached through i2c buffers of two sizes */
+static eeprom_i2c_sim_device<eeprom_i2c_m24c64> m_device;
+static eeprom_i2c<eeprom_i2c_m24c64, eeprom_i2c_sim<eeprom_i2c_m24c64, 32> > m_eeprom_32;
+static eeprom_i2c<eeprom_i2c_m24c64, eeprom_i2c_sim<eeprom_i2c_m24c64, 128> > m_eeprom_128;
+
+/* Test data */
+static uint8_t m_record[64];
+static uint8_t m_check[1024];
+
+/**
+ * Prints the counters of the simulated device, then resets them once the device is idle.
+ * @param[in] name The name of the measure.
+ */
+static void result(const char* name) {
+    const struct eeprom_i2c_sim_counters& counters = m_device.counters();
+    Serial.print("result,");
+    Serial.print(name);
+    Serial.print(",");
+    Serial.print(counters.transactions);
+    Serial.print(",");
+    Serial.print(counters.write_cycles);
+    Serial.print(",");
+    Serial.println((uint32_t)(counters.duration_bus / 1000));
+
+    /* Let the last write cycle complete, as the drivers don't know about each other's writes */
+    delay(10);
+    m_device.counters_reset();
+}
+
+void setup(void) {
+
+    /* Setup serial */
+    Serial.begin(SIMULATOR_SERIAL_SPEED);
+    while (!Serial) {
+    }
+
+    /* Setup simulated device and drivers */
+    m_device.setup(SIMULATOR_I2C_ADDRESS);
+    m_device.clock(400000);
+    m_eeprom_32.setup(m_device, SIMULATOR_I2C_ADDRESS);
+    m_eeprom_128.setup(m_device, SIMULATOR_I2C_ADDRESS);
+
+    /* Leave the bus alone during write cycles, so that counters don't depend on the speed of the host */
+    m_eeprom_32.write_wait_setup(m_eeprom_32.WRITE_WAIT_MODE_TIMEOUT);
+    m_eeprom_128.write_wait_setup(m_eeprom_128.WRITE_WAIT_MODE_TIMEOUT);
+    for (size_t i = 0; i < sizeof(m_record); i++) {
+        m_record[i] = i;
+    }
+
+    /* Unaligned record, with a 32 bytes buffer that can't carry a full page */
+    m_eeprom_32.write(13, m_record, sizeof(m_record));
+    m_eeprom_32.flush();
+    result("write_record_buffer_32");
+
+    /* Same record, with a buffer that can carry a full page */
+    m_eeprom_128.write(13, m_record, sizeof(m_record));
+    m_eeprom_128.flush();
+    result("write_record_buffer_128");
+
+    /* Same record again, with compare before write */
+    m_eeprom_128.write_compare_setup(true);
+    m_eeprom_128.write(13, m_record, sizeof(m_record));
+    result("write_record_unchanged_compare");
+
+    /* Bulk reads */
+    m_eeprom_32.read(0, m_check, sizeof(m_check));
+    result("read_1024_buffer_32");
+    m_eeprom_128.read(0, m_check, sizeof(m_check));
+    result("read_1024_buffer_128");
+}
+
+void loop(void) {
+}
@@ -0,0 +1,25 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+/* Declarations of the part of the FreeRTOS kernel api used by the library, so that it can be compiled on a host, without a scheduler to link to */
+
+/* C/C++ libraries */
+#include <stdint.h>
+
+/* Port types */
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+/* Configuration, with the defaults of the kernel */
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configSTACK_DEPTH_TYPE uint16_t
+
+/* Constants */
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t size_item);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* const item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* const buffer, TickType_t ticks);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * Minimal Arduino api for building the library and its tests on a host.
+ * @note Time is simulated: it only moves forward when delays are called or when it is read, by one microsecond per read so that busy loops always end.
+ */
+
+/* C/C++ libraries */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Simulated time, in microseconds */
+extern uint64_t arduino_shim_time;
+static inline unsigned long micros(void) {
+    arduino_shim_time++;
+    return (unsigned long)(uint32_t)arduino_shim_time;
+}
+static inline unsigned long millis(void) {
+    arduino_shim_time++;
+    return (unsigned long)(uint32_t)(arduino_shim_time / 1000);
+}
+static inline void delay(const unsigned long ms) {
+    arduino_shim_time += (uint64_t)ms * 1000;
+}
+static inline void delayMicroseconds(const unsigned int us) {
+    arduino_shim_time += us;
+}
+static inline void yield(void) {
+}
+
+/**
+ * Base of all outputs, with the subset of the print functions used by the library.
+ */
+class Print {
+   public:
+    virtual ~Print() {
+    }
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) {
+        size_t i = 0;
+        while (i < length && write(data[i]) == 1) {
+            i++;
+        }
+        return i;
+    }
+    size_t write(const char* text) {
+        return write((const uint8_t*)text, strlen(text));
+    }
+    size_t print(const char text) {
+        return write((uint8_t)text);
+    }
+    size_t print(const char* text) {
+        return write(text);
+    }
+    virtual void flush() {
+    }
+};
+
+/**
+ * Base of all inputs.
+ */
+class Stream : public Print {
+   public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#endif
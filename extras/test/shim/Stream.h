@@ -0,0 +1,7 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+/* The stream class is part of the minimal Arduino api */
+#include "Arduino.h"
+
+#endif
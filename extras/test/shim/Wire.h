@@ -0,0 +1,128 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+/* Arduino libraries */
+#include "Arduino.h"
+
+/* Size of the transmit and receive buffers, as in the AVR core */
+#define BUFFER_LENGTH 32
+
+/**
+ * Device attached to the mock i2c bus.
+ */
+class wire_mock_device {
+   public:
+    virtual ~wire_mock_device() {
+    }
+
+    /**
+     * Handles a write transaction, or a probe when there are no bytes.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @param[in] data The bytes sent after the device address byte.
+     * @param[in] length The number of bytes.
+     * @param[in] stop true if the transaction ends with a stop condition.
+     * @return true if the device acknowledged all bytes, or false otherwise.
+     */
+    virtual bool write(const uint8_t i2c_address, const uint8_t* const data, const size_t length, const bool stop) = 0;
+
+    /**
+     * Handles a read transaction.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @param[out] data A buffer to store the bytes read.
+     * @param[in] length The number of bytes to read.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    virtual bool read(const uint8_t i2c_address, uint8_t* const data, const size_t length) = 0;
+};
+
+/**
+ * Mock of the Arduino TwoWire library, which hands transactions over to the attached devices.
+ * @note Transmit and receive buffers are limited to BUFFER_LENGTH bytes, like on the real cores.
+ */
+class TwoWire : public Stream {
+   public:
+    void begin(void) {
+    }
+    void end(void) {
+        m_devices_count = 0;
+    }
+    int attach(wire_mock_device& device) {
+        if (m_devices_count >= sizeof(m_devices) / sizeof(m_devices[0])) {
+            return -1;
+        }
+        m_devices[m_devices_count++] = &device;
+        return 0;
+    }
+    void setClock(const uint32_t frequency) {
+        m_clock = frequency;
+    }
+    uint32_t clock(void) {
+        return m_clock;
+    }
+
+    void beginTransmission(const uint8_t i2c_address) {
+        m_tx_address = i2c_address;
+        m_tx_length = 0;
+    }
+    size_t write(uint8_t data) {
+        if (m_tx_length >= BUFFER_LENGTH) {
+            return 0;
+        }
+        m_tx_buffer[m_tx_length++] = data;
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t length) {
+        size_t i = 0;
+        while (i < length && write(data[i]) == 1) {
+            i++;
+        }
+        return i;
+    }
+    uint8_t endTransmission(const bool stop = true) {
+        for (size_t i = 0; i < m_devices_count; i++) {
+            if (m_devices[i]->write(m_tx_address, m_tx_buffer, m_tx_length, stop)) {
+                return 0;
+            }
+        }
+        return 2;
+    }
+
+    size_t requestFrom(const uint8_t i2c_address, size_t length) {
+        m_rx_length = 0;
+        m_rx_index = 0;
+        if (length > BUFFER_LENGTH) {
+            length = BUFFER_LENGTH;
+        }
+        for (size_t i = 0; i < m_devices_count; i++) {
+            if (m_devices[i]->read(i2c_address, m_rx_buffer, length)) {
+                m_rx_length = length;
+                break;
+            }
+        }
+        return m_rx_length;
+    }
+    int available() {
+        return m_rx_length - m_rx_index;
+    }
+    int read() {
+        return (m_rx_index < m_rx_length) ? m_rx_buffer[m_rx_index++] : -1;
+    }
+    int peek() {
+        return (m_rx_index < m_rx_length) ? m_rx_buffer[m_rx_index] : -1;
+    }
+
+   protected:
+    wire_mock_device* m_devices[8];
+    size_t m_devices_count = 0;
+    uint32_t m_clock = 100000;
+    uint8_t m_tx_address = 0;
+    uint8_t m_tx_buffer[BUFFER_LENGTH];
+    size_t m_tx_length = 0;
+    uint8_t m_rx_buffer[BUFFER_LENGTH];
+    size_t m_rx_length = 0;
+    size_t m_rx_index = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
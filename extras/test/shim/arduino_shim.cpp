@@ -0,0 +1,7 @@
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Wire.h>
+
+/* Simulated time and default bus */
+uint64_t arduino_shim_time = 0;
+TwoWire Wire;
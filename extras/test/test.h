@@ -0,0 +1,75 @@
+#ifndef TEST_H
+#define TEST_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Wire.h>
+
+/* C/C++ libraries */
+#include <stdio.h>
+
+/* Project code */
+#include "eeprom_i2c_sim.h"
+
+/* Assertions, which report failures and let the test carry on */
+static int test_failures = 0;
+#define TEST_ASSERT(condition)                                                          \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            printf("%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+            test_failures++;                                                            \
+        }                                                                               \
+    } while (0)
+#define TEST_RUN(test)           \
+    do {                         \
+        printf("%s\n", #test);  \
+        test();                  \
+    } while (0)
+#define TEST_RESULT() ((test_failures == 0) ? 0 : 1)
+
+/**
+ * Simulated eeprom attached to the mock TwoWire, so that tests go through the same transport as sketches.
+ * @note The first bytes of each write transaction are handed over to the simulated device as its memory address.
+ * @tparam descriptor The descriptor of the simulated device.
+ */
+template <class descriptor>
+class wire_mock_eeprom : public wire_mock_device {
+   public:
+    eeprom_i2c_sim_device<descriptor> device;
+
+    int setup(TwoWire& wire, const uint8_t i2c_address, const uint32_t duration_write_cycle = descriptor::duration_write_cycle) {
+        int res = device.setup(i2c_address, duration_write_cycle);
+        if (res < 0) {
+            return res;
+        }
+        return wire.attach(*this);
+    }
+    bool write(const uint8_t i2c_address, const uint8_t* const data, const size_t length, const bool stop) {
+        size_t header_length = (length < descriptor::address_width) ? length : descriptor::address_width;
+        return device.write(i2c_address, data, header_length, &data[header_length], length - header_length, stop);
+    }
+    bool read(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        return device.read(i2c_address, data, length);
+    }
+};
+
+/**
+ * Starts a test with a blank simulated device on the bus, once the write cycle left by the previous test has ended.
+ * @note Devices attached by the previous test are detached first, so call it before attaching the other devices of the test.
+ * @param[in] mock The simulated device to attach.
+ * @param[in] i2c_address The i2c address of the device.
+ * @param[in] duration_write_cycle The duration of its internal write cycle, in microseconds.
+ * @param[out] data An optional buffer to fill with test bytes, that differ from one address to the next, or NULL.
+ * @param[in] length The size of the buffer.
+ */
+template <class descriptor>
+static void test_fixture(wire_mock_eeprom<descriptor>& mock, const uint8_t i2c_address, const uint32_t duration_write_cycle, uint8_t* const data = NULL, const size_t length = 0) {
+    delay(10);
+    Wire.end();
+    TEST_ASSERT(mock.setup(Wire, i2c_address, duration_write_cycle) == 0);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = i * 7 + 3;
+    }
+}
+
+#endif
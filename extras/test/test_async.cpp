@@ -0,0 +1,120 @@
+/* Project code */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices, one over the mock TwoWire, and one over a simulated transport whose transfers don't block */
+typedef eeprom_i2c<eeprom_i2c_m24c64, eeprom_i2c_sim<eeprom_i2c_m24c64, 32> > m24c64_sim;
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static eeprom_i2c_sim_device<eeprom_i2c_m24c64> m_device;
+static m24c64_sim m_eeprom_sim;
+static uint8_t m_data[100];
+static uint8_t m_check[100];
+
+/**
+ * Attaches blank devices, and sets the drivers up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(m_device.setup(0x50, 3000) == 0);
+    TEST_ASSERT(m_eeprom_sim.setup(m_device, 0x50) == 0);
+    memset(m_check, 0, sizeof(m_check));
+}
+
+/**
+ * Polls a non blocking operation until it is over.
+ * @param[in] poll The poll function of the operation.
+ * @param[out] polls The number of calls that reported it in progress.
+ * @return The result of the operation.
+ */
+template <class eeprom, class core>
+static int async_run(eeprom& storage, int (core::*poll)(void), uint32_t& polls) {
+    int res;
+    polls = 0;
+    while ((res = (storage.*poll)()) == -EINPROGRESS) {
+        polls++;
+    }
+    return res;
+}
+
+/**
+ * Checks that a non blocking write then read over the blocking Wire transport transfer all bytes, across pages and chunks.
+ */
+static void test_wire(void) {
+    fixture();
+    uint32_t polls;
+    TEST_ASSERT(m_eeprom.write_async(20, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(async_run(m_eeprom, &m24c64::write_async_poll, polls) == (int)sizeof(m_data));
+    delay(10);  // Let the last write cycle end, so that the read isn't held back by it
+    TEST_ASSERT(m_eeprom.read_async(20, m_check, sizeof(m_check)) == 0);
+    TEST_ASSERT(m_eeprom.read_async(20, m_check, sizeof(m_check)) == -EBUSY);
+    TEST_ASSERT(m_eeprom.write_async(20, m_data, sizeof(m_data)) == -EBUSY);
+    TEST_ASSERT(async_run(m_eeprom, &m24c64::read_async_poll, polls) == (int)sizeof(m_check));
+    TEST_ASSERT(polls == 4);  // One transfer per call: the memory address, then four chunks
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_eeprom.read_async_poll() == -EINVAL);
+}
+
+/**
+ * Checks that a transport whose transfers don't block is left running on its own, the driver returning while the bytes are on the bus.
+ */
+static void test_transfer(void) {
+    fixture();
+    uint32_t polls;
+    TEST_ASSERT(m_eeprom_sim.write_wait_setup(m24c64_sim::WRITE_WAIT_MODE_TIMEOUT) == 0);
+    TEST_ASSERT(m_eeprom_sim.write_async(20, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(async_run(m_eeprom_sim, &m24c64_sim::write_async_poll, polls) == (int)sizeof(m_data));
+    TEST_ASSERT(m_device.counters().write_cycles == m24c64_sim::write_transactions(20, sizeof(m_data)));
+    TEST_ASSERT(memcmp(&m_device.memory()[20], m_data, sizeof(m_data)) == 0);
+
+    /* No polls of the device during write cycles, so the calls in progress were waiting for the transfers and cycles */
+    TEST_ASSERT(m_device.counters().nacks == 0);
+    TEST_ASSERT(polls > 0);
+    TEST_ASSERT(m_eeprom_sim.read_async(20, m_check, sizeof(m_check)) == 0);
+    TEST_ASSERT(m_eeprom_sim.read_async_poll() == -EINPROGRESS);
+    TEST_ASSERT(async_run(m_eeprom_sim, &m24c64_sim::read_async_poll, polls) == (int)sizeof(m_check));
+    TEST_ASSERT(polls > 1000);  // Several calls per transfer, each one taking milliseconds at 100 kHz
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+}
+
+/**
+ * Checks that a blocking read issued while a non blocking read is in flight lets it complete, and that it then sends its memory address again.
+ */
+static void test_interleaved(void) {
+    fixture();
+    uint8_t other[10];
+    memcpy(&m_device.memory()[0], m_data, sizeof(m_data));
+    memcpy(&m_device.memory()[1000], m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom_sim.read_async(0, m_check, sizeof(m_check)) == 0);
+    for (int i = 0; i < 4; i++) {
+        m_eeprom_sim.read_async_poll();
+    }
+    TEST_ASSERT(m_eeprom_sim.read(1000 + 50, other, sizeof(other)) == (int)sizeof(other));
+    TEST_ASSERT(memcmp(other, &m_data[50], sizeof(other)) == 0);
+    uint32_t polls;
+    TEST_ASSERT(async_run(m_eeprom_sim, &m24c64_sim::read_async_poll, polls) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+}
+
+/**
+ * Checks that a read past the end of the device is capped, and that a missing device ends it with an error.
+ */
+static void test_limits(void) {
+    fixture();
+    uint32_t polls;
+    TEST_ASSERT(m_eeprom_sim.read_async(m24c64_sim::size_total(), m_check, 1) == -EINVAL);
+    TEST_ASSERT(m_eeprom_sim.read_async(m24c64_sim::size_total() - 10, m_check, sizeof(m_check)) == 0);
+    TEST_ASSERT(async_run(m_eeprom_sim, &m24c64_sim::read_async_poll, polls) == 10);
+    TEST_ASSERT(m_eeprom_sim.setup(m_device, 0x54) == 0);
+    TEST_ASSERT(m_eeprom_sim.read_async(0, m_check, sizeof(m_check)) == 0);
+    TEST_ASSERT(async_run(m_eeprom_sim, &m24c64_sim::read_async_poll, polls) == -EIO);
+}
+
+int main(void) {
+    TEST_RUN(test_wire);
+    TEST_RUN(test_transfer);
+    TEST_RUN(test_interleaved);
+    TEST_RUN(test_limits);
+    return TEST_RESULT();
+}
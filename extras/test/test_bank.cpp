@@ -0,0 +1,72 @@
+/* Project code */
+#include "eeprom_i2c_bank.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mocks[2];
+static eeprom_i2c_sim_device<eeprom_i2c_m24c64> m_sims[2];
+static eeprom_i2c_bank<eeprom_i2c_m24c64, 2> m_bank;
+static eeprom_i2c_bank<eeprom_i2c_m24c64, 2, eeprom_i2c_sim<eeprom_i2c_m24c64> > m_bank_sim;
+static const uint8_t m_addresses[2] = {0x50, 0x51};
+static uint8_t m_data[256];
+static uint8_t m_check[256];
+
+/**
+ * Attaches two blank devices to the bus.
+ */
+static void fixture(void) {
+    test_fixture(m_mocks[0], m_addresses[0], 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_mocks[1].setup(Wire, m_addresses[1], 3000) == 0);
+}
+
+/**
+ * Checks that a write across the end of the first device continues at the start of the second one.
+ */
+static void test_concatenated(void) {
+    fixture();
+    TEST_ASSERT(m_bank.setup(Wire, m_addresses, false) == 0);
+    TEST_ASSERT(m_bank.detect() == true);
+    TEST_ASSERT(m_bank.write(8192 - 100, m_data, 200) == 200);
+    TEST_ASSERT(memcmp(&m_mocks[0].device.memory()[8192 - 100], m_data, 100) == 0);
+    TEST_ASSERT(memcmp(m_mocks[1].device.memory(), &m_data[100], 100) == 0);
+    TEST_ASSERT(m_bank.read(8192 - 100, m_check, 200) == 200);
+    TEST_ASSERT(memcmp(m_check, m_data, 200) == 0);
+}
+
+/**
+ * Checks that consecutive pages go to consecutive devices.
+ */
+static void test_interleaved(void) {
+    fixture();
+    TEST_ASSERT(m_bank.setup(Wire, m_addresses, true) == 0);
+    TEST_ASSERT(m_bank.write(0, m_data, 128) == 128);
+    TEST_ASSERT(memcmp(m_mocks[0].device.memory(), &m_data[0], 32) == 0);
+    TEST_ASSERT(memcmp(m_mocks[1].device.memory(), &m_data[32], 32) == 0);
+    TEST_ASSERT(memcmp(&m_mocks[0].device.memory()[32], &m_data[64], 32) == 0);
+    TEST_ASSERT(m_bank.read(0, m_check, 128) == 128);
+    TEST_ASSERT(memcmp(m_check, m_data, 128) == 0);
+}
+
+/**
+ * Checks that a bank also runs over simulated devices chained on the same simulated bus.
+ */
+static void test_simulated(void) {
+    fixture();
+    for (uint8_t i = 0; i < 2; i++) {
+        TEST_ASSERT(m_sims[i].setup(m_addresses[i], 3000) == 0);
+    }
+    m_sims[0].chain(&m_sims[1]);
+    TEST_ASSERT(m_bank_sim.setup(m_sims[0], m_addresses, true) == 0);
+    TEST_ASSERT(m_bank_sim.detect() == true);
+    TEST_ASSERT(m_bank_sim.write(16, m_data, 200) == 200);
+    TEST_ASSERT(m_bank_sim.read(16, m_check, 200) == 200);
+    TEST_ASSERT(memcmp(m_check, m_data, 200) == 0);
+    TEST_ASSERT(m_sims[0].counters().write_cycles > 0 && m_sims[1].counters().write_cycles > 0);
+}
+
+int main(void) {
+    TEST_RUN(test_concatenated);
+    TEST_RUN(test_interleaved);
+    TEST_RUN(test_simulated);
+    return TEST_RESULT();
+}
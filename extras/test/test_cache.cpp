@@ -0,0 +1,126 @@
+/* Project code */
+#include "eeprom_cache.h"
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices, with a cache of 2 pages */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+typedef eeprom_cache<m24c64, 2> cache;
+static uint8_t m_data[64];
+static uint8_t m_check[64];
+
+/**
+ * Attaches a device to the bus, with test bytes in its first pages, and sets the driver and the cache up.
+ * @param[in] c The cache.
+ * @param[in] mode The write policy of the cache.
+ */
+static void fixture(cache& c, const enum cache::cache_mode mode) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    for (size_t i = 0; i < 256; i++) {
+        m_mock.device.memory()[i] = i;
+    }
+    TEST_ASSERT(c.setup(m_eeprom, mode) == 0);
+}
+
+/**
+ * Checks that pages are loaded once, and that reads served from cached pages cost no bus transaction.
+ */
+static void test_read_hit(void) {
+    cache c;
+    fixture(c, cache::CACHE_MODE_WRITE_THROUGH);
+    TEST_ASSERT(c.read(40, m_check, 40) == 40);
+    for (size_t i = 0; i < 40; i++) {
+        TEST_ASSERT(m_check[i] == 40 + i);
+    }
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.read(32, m_check, 64) == 64);
+    TEST_ASSERT(c.read(63, m_check, 1) == 1 && m_check[0] == 63);
+    TEST_ASSERT(m_mock.device.counters().transactions == 0);
+    TEST_ASSERT(c.read(m24c64::size_total(), m_check, 1) == -EINVAL);
+}
+
+/**
+ * Checks that write through mode writes the eeprom at once, keeps cached pages up to date, and never leaves anything for sync().
+ */
+static void test_write_through(void) {
+    cache c;
+    fixture(c, cache::CACHE_MODE_WRITE_THROUGH);
+    TEST_ASSERT(c.read(32, m_check, 1) == 1);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.write(40, m_data, 30) == 30);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(40, 30));
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[40], m_data, 30) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.read(40, m_check, 24) == 24);
+    TEST_ASSERT(memcmp(m_check, m_data, 24) == 0);
+    TEST_ASSERT(m_mock.device.counters().transactions == 0);
+    TEST_ASSERT(c.sync() == 0);
+    TEST_ASSERT(c.invalidate() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    TEST_ASSERT(c.read(64, m_check, 6) == 6);
+    TEST_ASSERT(memcmp(m_check, &m_data[24], 6) == 0);
+}
+
+/**
+ * Checks that write back mode only writes the eeprom on sync(), once per dirty page and only for its dirty bytes.
+ */
+static void test_write_back_sync(void) {
+    cache c;
+    fixture(c, cache::CACHE_MODE_WRITE_BACK);
+    TEST_ASSERT(c.write(36, m_data, 4) == 4);
+    TEST_ASSERT(c.write(50, &m_data[4], 4) == 4);
+    TEST_ASSERT(c.write(64, m_data, 32) == 32);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    TEST_ASSERT(m_mock.device.memory()[36] == 36 && m_mock.device.memory()[64] == 64);
+    TEST_ASSERT(c.read(36, m_check, 4) == 4);
+    TEST_ASSERT(memcmp(m_check, m_data, 4) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.sync() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(36, 18) + m24c64::write_transactions(64, 32));
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[36], m_data, 4) == 0);
+    TEST_ASSERT(m_mock.device.memory()[40] == 40 && m_mock.device.memory()[49] == 49);
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[50], &m_data[4], 4) == 0);
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[64], m_data, 32) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.sync() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+}
+
+/**
+ * Checks that write back mode writes a dirty page out when it is evicted, the victim being picked by the clock algorithm.
+ */
+static void test_write_back_evict(void) {
+    cache c;
+    fixture(c, cache::CACHE_MODE_WRITE_BACK);
+    TEST_ASSERT(c.write(0, m_data, 8) == 8);
+    TEST_ASSERT(c.write(32, &m_data[8], 8) == 8);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+
+    /* Both pages have been referenced, so the sweep comes back to the first one, and evicts it */
+    TEST_ASSERT(c.read(64, m_check, 1) == 1 && m_check[0] == 64);
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[0], m_data, 8) == 0);
+    TEST_ASSERT(m_mock.device.memory()[32] == 32);
+
+    /* The second page is evicted next, while the page just loaded is kept */
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.read(96, m_check, 1) == 1 && m_check[0] == 96);
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[32], &m_data[8], 8) == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(32, 8));
+    m_mock.device.counters_reset();
+    TEST_ASSERT(c.read(64, m_check, 1) == 1 && m_check[0] == 64);
+    TEST_ASSERT(m_mock.device.counters().transactions == 0);
+
+    /* Evicted pages come back from the eeprom with the bytes written */
+    TEST_ASSERT(c.read(0, m_check, 8) == 8);
+    TEST_ASSERT(memcmp(m_check, m_data, 8) == 0);
+}
+
+int main(void) {
+    TEST_RUN(test_read_hit);
+    TEST_RUN(test_write_through);
+    TEST_RUN(test_write_back_sync);
+    TEST_RUN(test_write_back_evict);
+    return TEST_RESULT();
+}
@@ -0,0 +1,69 @@
+/* Project code */
+#include "eeprom_crc.h"
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static uint8_t m_data[100];
+static uint8_t m_check[100];
+
+/**
+ * Checks the crcs against the check values of their catalogue, computed over "123456789".
+ */
+static void test_check_values(void) {
+    const uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT(eeprom_crc8(0x00, data, sizeof(data)) == 0xF4);
+    TEST_ASSERT(eeprom_crc16(0xFFFF, data, sizeof(data)) == 0x29B1);
+    TEST_ASSERT(eeprom_crc16(eeprom_crc16(0xFFFF, data, 4), &data[4], 5) == 0x29B1);
+}
+
+/**
+ * Checks that every translation unit uses the same table.
+ */
+const uint16_t* test_crc_table_other(void);
+static void test_single_table(void) {
+    TEST_ASSERT(test_crc_table_other() == eeprom_crc16_table());
+}
+
+/**
+ * Checks that a block is stored with its crc right after it, in the same page writes, and read back once checked.
+ */
+static void test_block(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(m_eeprom.write_block(20, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(20, sizeof(m_data) + 2));
+    uint16_t crc = eeprom_crc16(0xFFFF, m_data, sizeof(m_data));
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[20], m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_mock.device.memory()[120] == (uint8_t)(crc >> 0) && m_mock.device.memory()[121] == (uint8_t)(crc >> 8));
+    TEST_ASSERT(m_mock.device.memory()[122] == 0xFF);
+    TEST_ASSERT(m_eeprom.read_block(20, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_eeprom.write_block(8190, m_data, 1) == -EINVAL);
+    TEST_ASSERT(m_eeprom.write_block(8189, m_data, 1) == 1);
+    TEST_ASSERT(m_eeprom.read_block(8189, m_check, 1) == 1);
+}
+
+/**
+ * Checks that a corrupted byte of the block or of its crc fails the read.
+ */
+static void test_block_corrupted(void) {
+    const uint32_t offsets[] = {0, 57, 99, 100, 101};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+        TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+        TEST_ASSERT(m_eeprom.write_block(20, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+        m_mock.device.memory()[20 + offsets[i]] ^= 0x04;
+        TEST_ASSERT(m_eeprom.read_block(20, m_check, sizeof(m_check)) == -EBADMSG);
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_check_values);
+    TEST_RUN(test_single_table);
+    TEST_RUN(test_block);
+    TEST_RUN(test_block_corrupted);
+    return TEST_RESULT();
+}
@@ -0,0 +1,7 @@
+/* Project code */
+#include "eeprom_crc.h"
+
+/* Second translation unit including the crc table, for test_crc */
+const uint16_t* test_crc_table_other(void) {
+    return eeprom_crc16_table();
+}
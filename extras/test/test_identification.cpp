@@ -0,0 +1,59 @@
+/* Project code */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64_d> m_mock;
+static m24c64_d m_eeprom;
+static uint8_t m_data[32];
+static uint8_t m_check[32];
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+}
+
+/**
+ * Checks that the identification page is read from the device once, then served from ram.
+ */
+static void test_cache(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.identification_write(0, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.identification_read(0, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.identification_read(4, m_check, 8) == 8);
+    TEST_ASSERT(memcmp(m_check, &m_data[4], 8) == 0);
+    TEST_ASSERT(m_mock.device.counters().transactions == 0);
+}
+
+/**
+ * Checks that checking the lock leaves the page unlocked, that locking makes the page read only, and that the cached bytes stay valid.
+ */
+static void test_lock(void) {
+    fixture();
+    bool locked = true;
+    TEST_ASSERT(m_eeprom.identification_write(0, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.identification_locked(locked) == 0);
+    TEST_ASSERT(locked == false);
+    TEST_ASSERT(m_eeprom.identification_locked(locked) == 0);
+    TEST_ASSERT(locked == false);
+    TEST_ASSERT(m_eeprom.identification_read(0, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(m_eeprom.identification_lock() == 0);
+    TEST_ASSERT(m_eeprom.identification_locked(locked) == 0);
+    TEST_ASSERT(locked == true);
+    memset(m_check, 0, sizeof(m_check));
+    TEST_ASSERT(m_eeprom.identification_write(0, m_check, 1) < 0);
+    TEST_ASSERT(m_eeprom.identification_read(0, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_eeprom.write(0, m_data, 4) == 4);
+}
+
+int main(void) {
+    TEST_RUN(test_cache);
+    TEST_RUN(test_lock);
+    return TEST_RESULT();
+}
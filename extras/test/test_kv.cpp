@@ -0,0 +1,150 @@
+/* Project code */
+#include "eeprom_kv.h"
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices, with a store of 4 keys at most, over 16 pages, each value taking a pair of 2 page slots */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static const uint32_t m_address = 512;
+static const uint32_t m_length = 16 * 32;
+static const size_t m_size_value = 40;
+typedef eeprom_kv<m24c64, 4> kv;
+static uint8_t m_data[m_size_value];
+static uint8_t m_check[m_size_value];
+
+/**
+ * Attaches a blank device to the bus, and sets the driver and the store up.
+ * @param[in] store The store.
+ */
+static void fixture(kv& store) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(store.setup(m_eeprom, m_address, m_length, m_size_value) == 0);
+}
+
+/**
+ * Checks that values can be set, changed, got and removed, and that they are kept across reboots.
+ */
+static void test_set_get(void) {
+    kv store;
+    fixture(store);
+    TEST_ASSERT(store.count() == 0);
+    TEST_ASSERT(store.get(1, m_check, sizeof(m_check)) == -ENOENT);
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    TEST_ASSERT(store.set(2, m_data, 3) == 3);
+    TEST_ASSERT(store.set(3, NULL, 0) == 0);
+    TEST_ASSERT(store.count() == 3);
+    TEST_ASSERT(store.get(1, m_check, sizeof(m_check)) == 40);
+    TEST_ASSERT(memcmp(m_check, m_data, 40) == 0);
+    TEST_ASSERT(store.get(1, m_check, 10) == 10);
+    TEST_ASSERT(store.get(3, m_check, sizeof(m_check)) == 0);
+
+    /* Change a value a few times, so that both slots of its pair get used */
+    for (uint8_t i = 0; i < 3; i++) {
+        m_data[0] = i;
+        TEST_ASSERT(store.set(2, m_data, 5) == 5);
+        TEST_ASSERT(store.get(2, m_check, sizeof(m_check)) == 5);
+        TEST_ASSERT(memcmp(m_check, m_data, 5) == 0);
+    }
+    TEST_ASSERT(store.count() == 3);
+
+    /* Reload */
+    kv reloaded;
+    TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_length, m_size_value) == 0);
+    TEST_ASSERT(reloaded.count() == 3);
+    TEST_ASSERT(reloaded.get(2, m_check, sizeof(m_check)) == 5);
+    TEST_ASSERT(memcmp(m_check, m_data, 5) == 0);
+
+    /* Remove, also across reboots */
+    TEST_ASSERT(reloaded.remove(2) == 0);
+    TEST_ASSERT(reloaded.remove(2) == -ENOENT);
+    TEST_ASSERT(reloaded.get(2, m_check, sizeof(m_check)) == -ENOENT);
+    TEST_ASSERT(reloaded.get(1, m_check, sizeof(m_check)) == 40);
+    TEST_ASSERT(reloaded.count() == 2);
+    TEST_ASSERT(store.setup(m_eeprom, m_address, m_length, m_size_value) == 0);
+    TEST_ASSERT(store.count() == 2);
+    TEST_ASSERT(store.get(2, m_check, sizeof(m_check)) == -ENOENT);
+
+    /* Invalid parameters */
+    TEST_ASSERT(store.set(0xFFFF, m_data, 1) == -EINVAL);
+    TEST_ASSERT(store.set(4, m_data, m_size_value + 1) == -EINVAL);
+    TEST_ASSERT(store.setup(m_eeprom, m_address + 1, m_length, m_size_value) == -EINVAL);
+}
+
+/**
+ * Checks that new keys are refused once all pairs of slots are used, and accepted again once one is removed.
+ */
+static void test_full(void) {
+    kv store;
+    fixture(store);
+    for (uint16_t key = 10; key < 14; key++) {
+        TEST_ASSERT(store.set(key, m_data, 8) == 8);
+    }
+    TEST_ASSERT(store.set(14, m_data, 8) == -ENOSPC);
+    TEST_ASSERT(store.set(13, m_check, 8) == 8);
+    TEST_ASSERT(store.remove(11) == 0);
+    TEST_ASSERT(store.set(14, m_data, 8) == 8);
+    TEST_ASSERT(store.count() == 4);
+    for (uint16_t key = 10; key < 15; key++) {
+        TEST_ASSERT(store.get(key, m_check, sizeof(m_check)) == ((key == 11) ? -ENOENT : 8));
+    }
+}
+
+/**
+ * Checks that a value written again, or written with only some of its bytes changed, costs no write at all, or only the pages that differ.
+ */
+static void test_unchanged(void) {
+    kv store;
+    fixture(store);
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+
+    /* The spare slot already holds the same value, with an older generation, so only the header page is written */
+    m_data[39] ^= 0xFF;
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    m_data[39] ^= 0xFF;
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    m_mock.device.counters_reset();
+    m_data[39] ^= 0xFF;
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(0, m24c64::size_page()));
+}
+
+/**
+ * Checks that a torn write, which leaves the spare slot with a bad crc, gets the store back to the previous value after a reboot.
+ */
+static void test_torn(void) {
+    kv store;
+    fixture(store);
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    m_data[0] ^= 0xFF;
+    TEST_ASSERT(store.set(1, m_data, 40) == 40);
+    TEST_ASSERT(store.set(2, m_data, 4) == 4);
+
+    /* Tear the newest value of key 1, in the second slot of the first pair, which spans two pages */
+    m_mock.device.memory()[m_address + 2 * 32 + 45] ^= 0x01;
+    kv reloaded;
+    TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_length, m_size_value) == 0);
+    TEST_ASSERT(reloaded.count() == 2);
+    TEST_ASSERT(reloaded.get(1, m_check, sizeof(m_check)) == 40);
+    m_data[0] ^= 0xFF;
+    TEST_ASSERT(memcmp(m_check, m_data, 40) == 0);
+
+    /* The torn slot is the spare one, and is written again by the next change */
+    m_data[0] ^= 0xFF;
+    TEST_ASSERT(reloaded.set(1, m_data, 40) == 40);
+    TEST_ASSERT(store.setup(m_eeprom, m_address, m_length, m_size_value) == 0);
+    TEST_ASSERT(store.get(1, m_check, sizeof(m_check)) == 40);
+    TEST_ASSERT(memcmp(m_check, m_data, 40) == 0);
+}
+
+int main(void) {
+    TEST_RUN(test_set_get);
+    TEST_RUN(test_full);
+    TEST_RUN(test_unchanged);
+    TEST_RUN(test_torn);
+    return TEST_RESULT();
+}
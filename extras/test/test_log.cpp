@@ -0,0 +1,109 @@
+/* Project code */
+#include "eeprom_log.h"
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices, with a log over 8 pages */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static const uint32_t m_address = 256;
+static const uint32_t m_slots = 8;
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000);
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+}
+
+/**
+ * Appends records whose payload is their number, starting from 0.
+ * @param[in] log The log to append to.
+ * @param[in] count The number of records to append.
+ */
+static void append(eeprom_log<m24c64>& log, const uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT(log.append((const uint8_t*)&i, sizeof(i)) == (int)sizeof(i));
+    }
+}
+
+/**
+ * Checks that a log holds consecutive records, from a given oldest one to a given newest one.
+ * @param[in] log The log to check.
+ * @param[in] oldest The payload of the oldest record.
+ * @param[in] newest The payload of the newest record.
+ */
+static void check(eeprom_log<m24c64>& log, const uint32_t oldest, const uint32_t newest) {
+    uint32_t payload = 0xFFFFFFFF;
+    TEST_ASSERT(log.count() == newest - oldest + 1);
+    TEST_ASSERT(log.sequence() == newest);
+    for (uint32_t i = 0; i < log.count(); i++) {
+        TEST_ASSERT(log.read(i, (uint8_t*)&payload, sizeof(payload)) == (int)sizeof(payload));
+        TEST_ASSERT(payload == oldest + i);
+    }
+    TEST_ASSERT(log.read_latest((uint8_t*)&payload, sizeof(payload)) == (int)sizeof(payload));
+    TEST_ASSERT(payload == newest);
+    TEST_ASSERT(log.read(log.count(), (uint8_t*)&payload, sizeof(payload)) == -EINVAL);
+}
+
+/**
+ * Checks that an empty log has no records, and that records outside of its range are left alone.
+ */
+static void test_empty(void) {
+    fixture();
+    eeprom_log<m24c64> log;
+    uint8_t payload[4];
+    TEST_ASSERT(log.setup(m_eeprom, m_address, m_slots * m24c64::size_page()) == 0);
+    TEST_ASSERT(log.count() == 0);
+    TEST_ASSERT(log.read_latest(payload, sizeof(payload)) == -ENOENT);
+    append(log, 3 * m_slots);
+    TEST_ASSERT(m_mock.device.memory()[m_address - 1] == 0xFF);
+    TEST_ASSERT(m_mock.device.memory()[m_address + m_slots * m24c64::size_page()] == 0xFF);
+    TEST_ASSERT(log.setup(m_eeprom, m_address + 1, m_slots * m24c64::size_page()) == -EINVAL);
+    TEST_ASSERT(log.setup(m_eeprom, m_address, m24c64::size_page()) == -EINVAL);
+}
+
+/**
+ * Checks that the newest and oldest records are found again after a reboot, for every position of the head, before and after the log wraps around.
+ */
+static void test_reload(void) {
+    for (uint32_t count = 1; count <= 3 * m_slots; count++) {
+        fixture();
+        eeprom_log<m24c64> log;
+        TEST_ASSERT(log.setup(m_eeprom, m_address, m_slots * m24c64::size_page()) == 0);
+        append(log, count);
+        check(log, (count > m_slots) ? count - m_slots : 0, count - 1);
+        eeprom_log<m24c64> reloaded;
+        TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_slots * m24c64::size_page()) == 0);
+        check(reloaded, (count > m_slots) ? count - m_slots : 0, count - 1);
+    }
+}
+
+/**
+ * Checks that an interrupted append, which leaves a corrupted newest record, gets the log back to the record before it, wherever the head is.
+ */
+static void test_corrupted(void) {
+    for (uint32_t count = 2; count <= 3 * m_slots; count++) {
+        fixture();
+        eeprom_log<m24c64> log;
+        TEST_ASSERT(log.setup(m_eeprom, m_address, m_slots * m24c64::size_page()) == 0);
+        append(log, count);
+        m_mock.device.memory()[m_address + ((count - 1) % m_slots) * m24c64::size_page() + 6] ^= 0x01;
+        eeprom_log<m24c64> reloaded;
+        TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_slots * m24c64::size_page()) == 0);
+        check(reloaded, (count > m_slots) ? count - m_slots : 0, count - 2);
+
+        /* The next record goes over the corrupted one */
+        uint32_t payload = count - 1;
+        TEST_ASSERT(reloaded.append((const uint8_t*)&payload, sizeof(payload)) == (int)sizeof(payload));
+        check(reloaded, (count > m_slots) ? count - m_slots : 0, count - 1);
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_empty);
+    TEST_RUN(test_reload);
+    TEST_RUN(test_corrupted);
+    return TEST_RESULT();
+}
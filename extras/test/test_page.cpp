@@ -0,0 +1,340 @@
+/* Project code */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static uint8_t m_data[256];
+static uint8_t m_check[256];
+
+/* Settings stored as a whole, which fit in a page write when aligned */
+struct settings {
+    uint32_t magic;
+    uint32_t serial;
+    uint32_t flags;
+    uint16_t thresholds[8];
+};
+static_assert(sizeof(struct settings) == 28, "Unexpected padding");
+static_assert(m24c64::write_transactions(0, sizeof(struct settings)) == 1, "Aligned settings should take a single page write");
+static_assert(m24c64::write_transactions(20, sizeof(struct settings)) == 2, "Settings crossing a page should take two page writes");
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+}
+
+/**
+ * Checks that the simulated device wraps around within a page, as the real one does, when a transaction crosses its end.
+ */
+static void test_device_rollover(void) {
+    fixture();
+    const uint8_t transaction[] = {0x00, 0x1E, 1, 2, 3, 4};
+    Wire.beginTransmission(0x50);
+    Wire.write(transaction, sizeof(transaction));
+    TEST_ASSERT(Wire.endTransmission() == 0);
+    uint8_t* memory = m_mock.device.memory();
+    TEST_ASSERT(memory[30] == 1 && memory[31] == 2);
+    TEST_ASSERT(memory[0] == 3 && memory[1] == 4);
+    TEST_ASSERT(memory[32] == 0xFF);
+}
+
+/**
+ * Checks that unaligned writes are split at page boundaries into as few transactions as the bus buffer allows.
+ */
+static void test_write_split(void) {
+    const uint32_t addresses[] = {0, 20, 31, 32, 8100};
+    const size_t lengths[] = {1, 12, 40, 64, 92};
+    for (size_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); i++) {
+        for (size_t j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+            fixture();
+            m_mock.device.counters_reset();
+            TEST_ASSERT(m_eeprom.write(addresses[i], m_data, lengths[j]) == (int)lengths[j]);
+            TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(addresses[i], lengths[j]));
+            TEST_ASSERT(memcmp(&m_mock.device.memory()[addresses[i]], m_data, lengths[j]) == 0);
+            TEST_ASSERT(m_mock.device.memory()[addresses[i] + lengths[j]] == 0xFF);
+        }
+    }
+}
+
+/**
+ * Checks that reads span pages, and stop at the end of the memory.
+ */
+static void test_read(void) {
+    fixture();
+    memcpy(&m_mock.device.memory()[100], m_data, 200);
+    TEST_ASSERT(m_eeprom.read(100, m_check, 200) == 200);
+    TEST_ASSERT(memcmp(m_check, m_data, 200) == 0);
+    TEST_ASSERT(m_eeprom.read(8190, m_check, 4) == 2);
+    TEST_ASSERT(m_eeprom.read(8192, m_check, 1) == -EINVAL);
+}
+
+/**
+ * Checks that a read from a device that doesn't answer fails with an error, and isn't taken for an empty read.
+ */
+static void test_read_absent(void) {
+    fixture();
+    eeprom_i2c_wire wire;
+    TEST_ASSERT(wire.setup(Wire) == 0);
+    TEST_ASSERT(wire.read(0x50, m_check, 4) == 4);
+    TEST_ASSERT(wire.read(0x51, m_check, 4) == -EIO);
+    eeprom_i2c_sim<eeprom_i2c_m24c64> sim;
+    TEST_ASSERT(sim.setup(m_mock.device) == 0);
+    TEST_ASSERT(sim.read(0x51, m_check, 4) == -EIO);
+}
+
+/**
+ * Checks that the compare before write mode skips unchanged bytes, only writing the transactions whose bytes differ.
+ */
+static void test_write_compare(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write(0, m_data, 64) == 64);
+    TEST_ASSERT(m_eeprom.write_compare_setup(true) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.write(0, m_data, 64) == 64);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    m_data[5] ^= 0xFF;
+    m_data[40] ^= 0xFF;
+    m_data[41] ^= 0xFF;
+    TEST_ASSERT(m_eeprom.write(0, m_data, 64) == 64);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 2);
+    TEST_ASSERT(memcmp(m_mock.device.memory(), m_data, 64) == 0);
+    TEST_ASSERT(m_eeprom.write_compare_setup(false) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.write(0, m_data, 64) == 64);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(0, 64));
+}
+
+/**
+ * Checks that fill() and erase() set exactly their range, with as many transactions as a write of the same range.
+ */
+static void test_fill_erase(void) {
+    fixture();
+    memset(m_mock.device.memory(), 0x55, m24c64::size_total());
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.fill(20, 0xAA, 100) == 100);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(20, 100));
+    TEST_ASSERT(m_mock.device.memory()[19] == 0x55 && m_mock.device.memory()[120] == 0x55);
+    for (size_t i = 20; i < 120; i++) {
+        TEST_ASSERT(m_mock.device.memory()[i] == 0xAA);
+    }
+    TEST_ASSERT(m_eeprom.fill(8180, 0x00, 20) == 12);
+    TEST_ASSERT(m_eeprom.fill(8192, 0x00, 1) == -EINVAL);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.erase() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(0, m24c64::size_total()));
+    for (size_t i = 0; i < m24c64::size_total(); i++) {
+        TEST_ASSERT(m_mock.device.memory()[i] == 0xFF);
+    }
+}
+
+/**
+ * Checks that copies within the device end up with the original content of the source, whether the ranges overlap forwards, backwards or not at all.
+ */
+static void test_copy(void) {
+    const uint32_t source = 100;
+    const uint32_t destinations[] = {101, 131, 99, 45, 400};
+    static uint8_t expected[512];
+    for (size_t i = 0; i < sizeof(destinations) / sizeof(destinations[0]); i++) {
+        fixture();
+        memcpy(&m_mock.device.memory()[source], m_data, 200);
+        memcpy(expected, m_mock.device.memory(), sizeof(expected));
+        memmove(&expected[destinations[i]], &expected[source], 200);
+        TEST_ASSERT(m_eeprom.copy(source, destinations[i], 200) == 200);
+        TEST_ASSERT(memcmp(m_mock.device.memory(), expected, sizeof(expected)) == 0);
+    }
+    TEST_ASSERT(m_eeprom.copy(8100, 0, 200) == 92);
+    TEST_ASSERT(m_eeprom.copy(0, 8192, 1) == -EINVAL);
+}
+
+/**
+ * Checks that a copy to another device writes its pages, and leaves the source alone.
+ */
+static void test_copy_to(void) {
+    static wire_mock_eeprom<eeprom_i2c_m24c64> mock_destination;
+    m24c64 destination;
+    fixture();
+    TEST_ASSERT(mock_destination.setup(Wire, 0x51, 3000) == 0);
+    TEST_ASSERT(destination.setup(Wire, 0x51) == 0);
+    memcpy(&m_mock.device.memory()[10], m_data, 100);
+    TEST_ASSERT(m_eeprom.copy_to(destination, 10, 20, 100) == 100);
+    TEST_ASSERT(memcmp(&mock_destination.device.memory()[20], m_data, 100) == 0);
+    TEST_ASSERT(mock_destination.device.memory()[19] == 0xFF && mock_destination.device.memory()[120] == 0xFF);
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[10], m_data, 100) == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+}
+
+/**
+ * Simulated device that also records the range of bus clock frequencies its data transfers run at.
+ */
+class wire_mock_clocked : public wire_mock_eeprom<eeprom_i2c_m24c64> {
+   public:
+    uint32_t clock_min = UINT32_MAX;
+    uint32_t clock_max = 0;
+    void clock_reset(void) {
+        clock_min = UINT32_MAX;
+        clock_max = 0;
+    }
+    bool write(const uint8_t i2c_address, const uint8_t* const data, const size_t length, const bool stop) {
+        if (length > eeprom_i2c_m24c64::address_width) clock_record();
+        return wire_mock_eeprom<eeprom_i2c_m24c64>::write(i2c_address, data, length, stop);
+    }
+    bool read(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        clock_record();
+        return wire_mock_eeprom<eeprom_i2c_m24c64>::read(i2c_address, data, length);
+    }
+
+   protected:
+    void clock_record(void) {
+        if (Wire.clock() < clock_min) clock_min = Wire.clock();
+        if (Wire.clock() > clock_max) clock_max = Wire.clock();
+    }
+};
+
+/**
+ * Checks that bulk clock mode runs reads and page writes at the fastest frequency of the device, and puts the bus back at its own frequency in between.
+ */
+static void test_clock_bulk(void) {
+    static wire_mock_clocked mock;
+    m24c64 eeprom;
+    test_fixture(mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(eeprom.setup(Wire, 0x50) == 0);
+    Wire.setClock(100000);
+    TEST_ASSERT(eeprom.clock_setup(100000, m24c64::CLOCK_MODE_BULK) == 0);
+    TEST_ASSERT(eeprom.clock_frequency() == eeprom_i2c_m24c64::frequency_max);
+    TEST_ASSERT(Wire.clock() == 100000);
+    mock.clock_reset();
+    TEST_ASSERT(eeprom.write(10, m_data, 100) == 100);
+    TEST_ASSERT(eeprom.read(10, m_check, 100) == 100);
+    TEST_ASSERT(memcmp(m_check, m_data, 100) == 0);
+    TEST_ASSERT(mock.clock_min == eeprom_i2c_m24c64::frequency_max && mock.clock_max == eeprom_i2c_m24c64::frequency_max);
+    TEST_ASSERT(Wire.clock() == 100000);
+
+    /* Fixed mode leaves the bus at the selected frequency, and a limit no faster than the bus leaves it alone */
+    TEST_ASSERT(eeprom.clock_setup(100000, m24c64::CLOCK_MODE_FIXED) == 0);
+    TEST_ASSERT(Wire.clock() == eeprom_i2c_m24c64::frequency_max);
+    TEST_ASSERT(eeprom.clock_setup(100000, m24c64::CLOCK_MODE_BULK, 100000) == 0);
+    TEST_ASSERT(eeprom.clock_frequency() == 0);
+    mock.clock_reset();
+    TEST_ASSERT(eeprom.read(10, m_check, 100) == 100);
+    TEST_ASSERT(mock.clock_max == 100000 && Wire.clock() == 100000);
+    TEST_ASSERT(eeprom.clock_setup(0, m24c64::CLOCK_MODE_BULK) == -EINVAL);
+}
+
+/**
+ * Checks that objects are written with as few page writes as write_transactions() gives, and read back as a whole.
+ */
+static void test_put_get(void) {
+    const uint32_t addresses[] = {0, 20, m24c64::size_total() - sizeof(struct settings)};
+    for (size_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); i++) {
+        fixture();
+        struct settings written = {0xC0FFEE42, (uint32_t)i, 0x5A, {1, 2, 3, 4, 5, 6, 7, 8}};
+        struct settings read;
+        memset(&read, 0, sizeof(read));
+        m_mock.device.counters_reset();
+        TEST_ASSERT(m_eeprom.put(addresses[i], written) == (int)sizeof(written));
+        TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(addresses[i], sizeof(written)));
+        TEST_ASSERT(m_eeprom.get(addresses[i], read) == (int)sizeof(read));
+        TEST_ASSERT(memcmp(&read, &written, sizeof(written)) == 0);
+    }
+    struct settings read = {0, 0, 0, {0}};
+    TEST_ASSERT(m_eeprom.get(m24c64::size_total() - sizeof(read) + 1, read) == -EINVAL);
+    TEST_ASSERT(m_eeprom.put(m24c64::size_total() - sizeof(read) + 1, read) == -EINVAL);
+}
+
+/**
+ * Checks that segments are written as if they were a single buffer, and read back into other segments as a single read would.
+ */
+static void test_writev_readv(void) {
+    fixture();
+    const struct eeprom_i2c_segment_const written[] = {
+        {&m_data[0], 4}, {&m_data[4], 0}, {&m_data[4], 50}, {&m_data[54], 3}, {&m_data[57], 40},
+    };
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.writev(10, written, sizeof(written) / sizeof(written[0])) == 97);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(10, 97));
+    TEST_ASSERT(memcmp(&m_mock.device.memory()[10], m_data, 97) == 0);
+    TEST_ASSERT(m_mock.device.memory()[9] == 0xFF && m_mock.device.memory()[107] == 0xFF);
+
+    /* Read back with a different split, with as many transactions as a plain read, once the last write cycle is over */
+    delay(10);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.read(10, m_check, 97) == 97);
+    size_t transactions = m_mock.device.counters().transactions;
+    m_mock.device.counters_reset();
+    memset(m_check, 0, sizeof(m_check));
+    const struct eeprom_i2c_segment read[] = {
+        {&m_check[0], 7}, {&m_check[7], 0}, {&m_check[7], 60}, {&m_check[67], 30},
+    };
+    TEST_ASSERT(m_eeprom.readv(10, read, sizeof(read) / sizeof(read[0])) == 97);
+    TEST_ASSERT(m_mock.device.counters().transactions == transactions);
+    TEST_ASSERT(memcmp(m_check, m_data, 97) == 0);
+    TEST_ASSERT(m_check[97] == 0);
+
+    /* Out of range */
+    TEST_ASSERT(m_eeprom.writev(m24c64::size_total(), written, 1) == -EINVAL);
+}
+
+/**
+ * Checks that scattered requests are sorted, merged with their neighbours when the gap is small enough, and each filled with its own bytes.
+ */
+static void test_read_batch(void) {
+    fixture();
+    for (size_t i = 0; i < 1024; i++) {
+        m_mock.device.memory()[i] = i;
+    }
+    uint8_t a[4], b[2], c[3], d[8], e[1];
+    struct eeprom_i2c_request requests[] = {
+        {300, a, sizeof(a)}, {10, b, sizeof(b)}, {14, c, sizeof(c)}, {500, d, sizeof(d)}, {11, e, sizeof(e)},
+    };
+    const size_t count = sizeof(requests) / sizeof(requests[0]);
+
+    /* Reads of the merged ranges, one by one */
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.read(10, m_check, 7) == 7);
+    TEST_ASSERT(m_eeprom.read(300, m_check, 4) == 4);
+    TEST_ASSERT(m_eeprom.read(500, m_check, 8) == 8);
+    size_t transactions = m_mock.device.counters().transactions;
+
+    /* Batch, with the three requests at the start merged */
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.read_batch(requests, count) == 0);
+    TEST_ASSERT(m_mock.device.counters().transactions == transactions);
+    for (size_t i = 1; i < count; i++) {
+        TEST_ASSERT(requests[i - 1].address <= requests[i].address);
+    }
+    TEST_ASSERT(a[0] == 300 % 256 && a[3] == 303 % 256);
+    TEST_ASSERT(b[0] == 10 && b[1] == 11);
+    TEST_ASSERT(c[0] == 14 && c[2] == 16);
+    TEST_ASSERT(d[0] == 500 % 256 && d[7] == 507 % 256);
+    TEST_ASSERT(e[0] == 11);
+
+    /* Without any gap, only the overlapping ones are merged */
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.read_batch(requests, count, 0) == 0);
+    TEST_ASSERT(m_mock.device.counters().transactions > transactions);
+    TEST_ASSERT(c[0] == 14 && c[2] == 16);
+
+    /* Out of range */
+    requests[0].address = m24c64::size_total() - 1;
+    TEST_ASSERT(m_eeprom.read_batch(requests, count) == -EINVAL);
+}
+
+int main(void) {
+    TEST_RUN(test_device_rollover);
+    TEST_RUN(test_write_split);
+    TEST_RUN(test_read);
+    TEST_RUN(test_read_absent);
+    TEST_RUN(test_write_compare);
+    TEST_RUN(test_fill_erase);
+    TEST_RUN(test_copy);
+    TEST_RUN(test_copy_to);
+    TEST_RUN(test_clock_bulk);
+    TEST_RUN(test_put_get);
+    TEST_RUN(test_writev_readv);
+    TEST_RUN(test_read_batch);
+    return TEST_RESULT();
+}
@@ -0,0 +1,10 @@
+/* Project code, compiled against declarations of the FreeRTOS api only, as there is no scheduler on the host */
+#include "eeprom_rtos.h"
+#include "m24c64.h"
+
+/* Every member of the thread safe layer and of its cursor */
+template class eeprom_rtos<m24c64>;
+template class eeprom_rtos_cursor<m24c64>;
+
+/* The default stack of the worker fits in the stack depth type of the kernel */
+static_assert((configSTACK_DEPTH_TYPE)EEPROM_RTOS_WORKER_STACK == EEPROM_RTOS_WORKER_STACK, "The default worker stack overflows the stack depth type");
@@ -0,0 +1,76 @@
+/* Project code, built with EEPROM_I2C_SLIM */
+#include "m24c64.h"
+#include "test.h"
+
+/* The optional features are all left out */
+#if defined(EEPROM_I2C_ASYNC) || defined(EEPROM_I2C_CLOCK) || defined(EEPROM_I2C_SLEEP) || defined(EEPROM_I2C_COMPARE) || defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+#error "The slim profile must leave all optional features out"
+#endif
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64_core m_eeprom;
+static wire_mock_eeprom<eeprom_i2c_m24c64_d> m_mock_d;
+static eeprom_i2c_core<eeprom_i2c_m24c64_d> m_eeprom_d;
+static uint8_t m_data[100];
+static uint8_t m_check[100];
+
+/* The instance only holds the transport, the device address and the write cycle state, unless statistics are built in too */
+#if !defined(EEPROM_I2C_STATS)
+static_assert(sizeof(m24c64_core) <= sizeof(eeprom_i2c_wire) + 32, "The slim core holds state of optional features");
+#endif
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+}
+
+/**
+ * Checks that writes and reads across pages work as with the full build.
+ */
+static void test_write_read(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write(20, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.read(20, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_eeprom.write_block(200, m_data, 40) == 40);
+    TEST_ASSERT(m_eeprom.read_block(200, m_check, 40) == 40);
+    TEST_ASSERT(memcmp(m_check, m_data, 40) == 0);
+}
+
+/**
+ * Checks that the sleep write wait mode is reported as left out, and that the other ones are still there.
+ */
+static void test_write_wait(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64_core::WRITE_WAIT_MODE_SLEEP, 0, delayMicroseconds) == -ENOTSUP);
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64_core::WRITE_WAIT_MODE_ADAPTIVE) == 0);
+    TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64_core::WRITE_WAIT_MODE_POLLING) == 0);
+}
+
+/**
+ * Checks that the identification page is read from the device every time, and only for the bytes asked for, on a device that has one.
+ */
+static void test_identification(void) {
+    test_fixture(m_mock_d, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom_d.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(m_eeprom_d.identification_write(0, m_data, 32) == 32);
+    TEST_ASSERT(m_eeprom_d.identification_read(5, m_check, 10) == 10);
+    TEST_ASSERT(memcmp(m_check, &m_data[5], 10) == 0);
+    m_mock_d.device.counters_reset();
+    TEST_ASSERT(m_eeprom_d.identification_read(0, m_check, 40) == 32);
+    TEST_ASSERT(memcmp(m_check, m_data, 32) == 0);
+    TEST_ASSERT(m_mock_d.device.counters().transactions >= 2);
+}
+
+int main(void) {
+    TEST_RUN(test_write_read);
+    TEST_RUN(test_write_wait);
+    TEST_RUN(test_identification);
+    return TEST_RESULT();
+}
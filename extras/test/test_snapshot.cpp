@@ -0,0 +1,91 @@
+/* Project code */
+#include "eeprom_snapshot.h"
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices, with a 100 bytes region saved as 30 bytes slices, hence over 4 pages */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static const uint32_t m_address = 1024;
+typedef eeprom_snapshot<m24c64, 100> snapshot;
+static uint8_t m_data[100];
+static uint8_t m_check[100];
+
+/**
+ * Attaches a blank device to the bus, and sets the driver and a snapshot of the test bytes up.
+ * @param[in] s The snapshot.
+ */
+static void fixture(snapshot& s) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(s.setup(m_eeprom, m_address, m_data) == 0);
+}
+
+/**
+ * Checks that a saved region is loaded back, and that the pages next to the snapshot are left alone.
+ */
+static void test_save_load(void) {
+    snapshot s, reloaded;
+    fixture(s);
+    TEST_ASSERT(s.save() == 4);
+    TEST_ASSERT(m_mock.device.memory()[m_address - 1] == 0xFF);
+    TEST_ASSERT(m_mock.device.memory()[m_address + 4 * 32] == 0xFF);
+    memset(m_check, 0, sizeof(m_check));
+    TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_check) == 0);
+    TEST_ASSERT(reloaded.load() == 0);
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(reloaded.save() == 0);
+    TEST_ASSERT(s.setup(m_eeprom, m_address + 1, m_data) == -EINVAL);
+    TEST_ASSERT(s.setup(m_eeprom, m24c64::size_total() - 3 * 32, m_data) == -EINVAL);
+}
+
+/**
+ * Checks that a save only writes the pages whose slice changed, and nothing at all when nothing changed.
+ */
+static void test_save_incremental(void) {
+    snapshot s;
+    fixture(s);
+    TEST_ASSERT(s.save_all() == 4);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(s.save() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    m_data[65] ^= 0xFF;
+    m_data[99] ^= 0xFF;
+    TEST_ASSERT(s.save() == 2);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == m24c64::write_transactions(m_address + 2 * 32, 32) + m24c64::write_transactions(m_address + 3 * 32, 12));
+    m_mock.device.counters_reset();
+    TEST_ASSERT(s.save() == 0);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    TEST_ASSERT(s.save_all() == 4);
+}
+
+/**
+ * Checks that a corrupted page fails the load, while the other slices are still restored, and that the next save writes it again.
+ */
+static void test_corrupted(void) {
+    snapshot s, reloaded;
+    fixture(s);
+    TEST_ASSERT(s.save() == 4);
+    m_mock.device.memory()[m_address + 32 + 7] ^= 0x01;
+    memset(m_check, 0, sizeof(m_check));
+    TEST_ASSERT(reloaded.setup(m_eeprom, m_address, m_check) == 0);
+    TEST_ASSERT(reloaded.load() == -EBADMSG);
+    TEST_ASSERT(memcmp(m_check, m_data, 30) == 0);
+    TEST_ASSERT(m_check[30] == 0 && m_check[59] == 0);
+    TEST_ASSERT(memcmp(&m_check[60], &m_data[60], 40) == 0);
+    memcpy(&m_check[30], &m_data[30], 30);
+    TEST_ASSERT(reloaded.save() == 4);
+    TEST_ASSERT(s.load() == 0);
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+
+    /* A blank eeprom holds no valid page either */
+    test_fixture(m_mock, 0x50, 3000);
+    TEST_ASSERT(s.load() == -EBADMSG);
+}
+
+int main(void) {
+    TEST_RUN(test_save_load);
+    TEST_RUN(test_save_incremental);
+    TEST_RUN(test_corrupted);
+    return TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+/* Project code, built with EEPROM_I2C_STATS */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static uint8_t m_data[100];
+static uint8_t m_check[100];
+
+/* Transactions seen by the hooks */
+struct hooks {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t errors;
+};
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+    m_eeprom.stats_reset();
+}
+
+/**
+ * Counts transactions about to start.
+ * @param[in] i2c_address
+ * @param[in] context A pointer to the counts.
+ */
+static void hook_begin(uint8_t i2c_address, void* context) {
+    struct hooks* counts = static_cast<struct hooks*>(context);
+    TEST_ASSERT((i2c_address & 0xF8) == 0x50);
+    TEST_ASSERT(counts->begin == counts->end);
+    counts->begin++;
+}
+
+/**
+ * Counts transactions that ended, and the ones that failed.
+ * @param[in] i2c_address
+ * @param[in] res The number of data bytes transferred, or a negative error code.
+ * @param[in] context A pointer to the counts.
+ */
+static void hook_end(uint8_t i2c_address, int res, void* context) {
+    struct hooks* counts = static_cast<struct hooks*>(context);
+    TEST_ASSERT((i2c_address & 0xF8) == 0x50);
+    counts->end++;
+    if (res == -EIO) counts->errors++;
+}
+
+/**
+ * Checks that the counters add up the bytes and transactions of writes and reads, as the device sees them.
+ */
+static void test_counters(void) {
+    fixture();
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.write(10, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.read(10, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    const struct eeprom_i2c_stats& stats = m_eeprom.stats();
+    TEST_ASSERT(stats.bytes_written == sizeof(m_data));
+    TEST_ASSERT(stats.bytes_read == sizeof(m_check));
+    TEST_ASSERT(stats.writes_page + stats.writes_byte == m24c64::write_transactions(10, sizeof(m_data)));
+    TEST_ASSERT(stats.writes_page + stats.writes_byte == m_mock.device.counters().write_cycles);
+    TEST_ASSERT(stats.transactions == m_mock.device.counters().transactions);
+    TEST_ASSERT(stats.polls > 0 && stats.polls >= m_mock.device.counters().nacks);
+    TEST_ASSERT(stats.duration_wait > 0);
+    TEST_ASSERT(stats.errors == 0);
+    m_eeprom.stats_reset();
+    TEST_ASSERT(m_eeprom.stats().transactions == 0 && m_eeprom.stats().bytes_written == 0);
+}
+
+/**
+ * Checks that the hooks are called around every transaction, and that failed transactions are counted as errors.
+ */
+static void test_hooks(void) {
+    fixture();
+    struct hooks counts = {0, 0, 0};
+    m_eeprom.stats_hooks(hook_begin, hook_end, &counts);
+    TEST_ASSERT(m_eeprom.write(0, m_data, 40) == 40);
+    TEST_ASSERT(m_eeprom.read(0, m_check, 40) == 40);
+    TEST_ASSERT(counts.begin == m_eeprom.stats().transactions && counts.end == counts.begin);
+    TEST_ASSERT(counts.errors == 0);
+
+    /* A device that doesn't answer */
+    m24c64 absent;
+    TEST_ASSERT(absent.setup(Wire, 0x53) == 0);
+    absent.stats_hooks(hook_begin, hook_end, &counts);
+    TEST_ASSERT(absent.read(0, m_check, 4) < 0);
+    TEST_ASSERT(absent.stats().errors == 1);
+    TEST_ASSERT(counts.errors == 1);
+    m_eeprom.stats_hooks(NULL, NULL);
+}
+
+/**
+ * Checks that the data byte a locked identification page refuses, which is the expected answer, isn't counted as an error.
+ */
+static void test_identification_locked(void) {
+    static wire_mock_eeprom<eeprom_i2c_m24c64_d> mock;
+    m24c64_d eeprom;
+    bool locked = false;
+    test_fixture(mock, 0x50, 3000);
+    TEST_ASSERT(eeprom.setup(Wire, 0x50) == 0);
+    TEST_ASSERT(eeprom.identification_lock() == 0);
+    delay(10);
+    eeprom.stats_reset();
+    TEST_ASSERT(eeprom.identification_locked(locked) == 0);
+    TEST_ASSERT(locked == true);
+    TEST_ASSERT(eeprom.stats().errors == 0);
+    TEST_ASSERT(eeprom.stats().transactions == 3);  // Probe, refused lock command and abort
+}
+
+int main(void) {
+    TEST_RUN(test_counters);
+    TEST_RUN(test_hooks);
+    TEST_RUN(test_identification_locked);
+    return TEST_RESULT();
+}
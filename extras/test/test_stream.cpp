@@ -0,0 +1,145 @@
+/* Project code */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static uint8_t m_read_ahead[16];
+static uint8_t m_data[64];
+
+/**
+ * Print object collecting what it is given, such as a serial port would send it.
+ */
+class print_buffer : public Print {
+   public:
+    uint8_t data[128];
+    size_t length = 0;
+    size_t calls = 0;
+    size_t write(uint8_t byte) {
+        return write(&byte, 1);
+    }
+    size_t write(const uint8_t* bytes, size_t count) {
+        calls++;
+        if (count > sizeof(data) - length) count = sizeof(data) - length;
+        memcpy(&data[length], bytes, count);
+        length += count;
+        return count;
+    }
+};
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up with a read ahead buffer.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50, m_read_ahead, sizeof(m_read_ahead)) == 0);
+}
+
+/**
+ * Checks that the read ahead buffer serves consecutive bytes with a single sequential read.
+ */
+static void test_read_ahead(void) {
+    fixture();
+    memcpy(m_mock.device.memory(), m_data, sizeof(m_data));
+    m_mock.device.counters_reset();
+    m_eeprom.seek_read(0);
+    for (size_t i = 0; i < sizeof(m_read_ahead); i++) {
+        TEST_ASSERT(m_eeprom.peek() == m_data[i]);
+        TEST_ASSERT(m_eeprom.read() == m_data[i]);
+    }
+    TEST_ASSERT(m_mock.device.counters().transactions == 2);
+}
+
+/**
+ * Checks that print output is combined into page writes, and only sent once complete or flushed.
+ */
+static void test_write_combining(void) {
+    fixture();
+    m_eeprom.seek_write(0);
+    m_mock.device.counters_reset();
+    for (size_t i = 0; i < 10; i++) {
+        TEST_ASSERT(m_eeprom.write(m_data[i]) == 1);
+    }
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 0);
+    m_eeprom.flush();
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 1);
+    TEST_ASSERT(memcmp(m_mock.device.memory(), m_data, 10) == 0);
+}
+
+/**
+ * Checks that bytes printed and not flushed yet are read back, even when the read ahead buffer holds the old ones.
+ */
+static void test_print_then_read(void) {
+    fixture();
+    m_eeprom.seek_read(0);
+    TEST_ASSERT(m_eeprom.peek() == 0xFF);
+    m_eeprom.seek_write(0);
+    TEST_ASSERT(m_eeprom.print('A') == 1);
+    TEST_ASSERT(m_eeprom.peek() == 'A');
+    TEST_ASSERT(m_eeprom.read() == 'A');
+    TEST_ASSERT(m_eeprom.read() == 0xFF);
+    m_eeprom.flush();
+    m_eeprom.seek_read(0);
+    TEST_ASSERT(m_eeprom.read() == 'A');
+}
+
+/**
+ * Checks that the read ahead buffer doesn't keep bytes read while a non blocking write of them was in progress.
+ */
+static void test_async_then_read(void) {
+    fixture();
+    uint8_t data[64];
+    memset(data, 0x11, sizeof(data));
+    TEST_ASSERT(m_eeprom.write_async(0, data, sizeof(data)) == 0);
+    TEST_ASSERT(m_eeprom.write_async_poll() == -EINPROGRESS);
+    m_eeprom.seek_read(40);
+    TEST_ASSERT(m_eeprom.read() == 0xFF);
+    int res;
+    while ((res = m_eeprom.write_async_poll()) == -EINPROGRESS) {
+    }
+    TEST_ASSERT(res == (int)sizeof(data));
+    m_eeprom.seek_read(40);
+    TEST_ASSERT(m_eeprom.read() == 0x11);
+}
+
+/**
+ * Counts the chunks handed over by read_to(), and checks they arrive in order.
+ * @param[in] data
+ * @param[in] length
+ * @param[in] context A pointer to the number of bytes received so far.
+ */
+static void read_to_chunk(const uint8_t* data, size_t length, void* context) {
+    size_t* received = static_cast<size_t*>(context);
+    TEST_ASSERT(length > 0 && length <= eeprom_i2c_wire::size_read_max());
+    TEST_ASSERT(memcmp(data, &m_data[*received], length) == 0);
+    *received += length;
+}
+
+/**
+ * Checks that read_to() streams bytes into a print object or a callback, one bus sized chunk at a time, with a single sequential read.
+ */
+static void test_read_to(void) {
+    fixture();
+    memcpy(m_mock.device.memory() + 100, m_data, sizeof(m_data));
+    print_buffer sink;
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.read_to(100, sizeof(m_data), sink) == (int)sizeof(m_data));
+    TEST_ASSERT(sink.length == sizeof(m_data));
+    TEST_ASSERT(memcmp(sink.data, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(sink.calls == 2);
+    TEST_ASSERT(m_mock.device.counters().transactions == 1 + 2);
+    size_t received = 0;
+    TEST_ASSERT(m_eeprom.read_to(100, sizeof(m_data), read_to_chunk, &received) == (int)sizeof(m_data));
+    TEST_ASSERT(received == sizeof(m_data));
+    TEST_ASSERT(m_eeprom.read_to(m24c64::size_total(), 1, sink) == -EINVAL);
+}
+
+int main(void) {
+    TEST_RUN(test_read_ahead);
+    TEST_RUN(test_write_combining);
+    TEST_RUN(test_print_then_read);
+    TEST_RUN(test_async_then_read);
+    TEST_RUN(test_read_to);
+    return TEST_RESULT();
+}
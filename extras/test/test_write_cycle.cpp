@@ -0,0 +1,133 @@
+/* Project code */
+#include "m24c64.h"
+#include "test.h"
+
+/* Devices */
+static wire_mock_eeprom<eeprom_i2c_m24c64> m_mock;
+static m24c64 m_eeprom;
+static uint8_t m_data[64];
+static uint8_t m_check[64];
+static uint32_t m_sleeps;
+static uint32_t m_sleep_duration;
+
+/**
+ * Attaches a blank device to the bus, and sets the driver up.
+ */
+static void fixture(void) {
+    test_fixture(m_mock, 0x50, 3000, m_data, sizeof(m_data));
+    TEST_ASSERT(m_eeprom.setup(Wire, 0x50) == 0);
+}
+
+/**
+ * Checks that the device is polled until it acknowledges again after a write cycle, and that nothing is lost.
+ */
+static void test_polling(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64::WRITE_WAIT_MODE_POLLING) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.write(0, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.read(0, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_mock.device.counters().nacks > 0);
+}
+
+/**
+ * Checks that the timeout mode stays off the bus until the write cycle is over.
+ */
+static void test_timeout(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64::WRITE_WAIT_MODE_TIMEOUT) == 0);
+    m_mock.device.counters_reset();
+    TEST_ASSERT(m_eeprom.write(0, m_data, sizeof(m_data)) == (int)sizeof(m_data));
+    TEST_ASSERT(m_eeprom.read(0, m_check, sizeof(m_check)) == (int)sizeof(m_check));
+    TEST_ASSERT(memcmp(m_check, m_data, sizeof(m_data)) == 0);
+    TEST_ASSERT(m_mock.device.counters().nacks == 0);
+}
+
+/**
+ * Performs the same sequence of one byte writes with a given write wait mode, once the mode had time to learn.
+ * @note Probes are spaced by about the bus time of a probe at 100 kHz, as the simulated time doesn't move forward with bus traffic.
+ * @param[in] mode The write wait mode.
+ * @return The number of probes the device didn't acknowledge during the sequence.
+ */
+static uint32_t write_sequence_nacks(const enum m24c64::write_wait_mode mode) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_wait_setup(mode, 200) == 0);
+    for (size_t i = 0; i < 16; i++) {
+        TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    }
+    m_mock.device.counters_reset();
+    for (size_t i = 0; i < 16; i++) {
+        TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    }
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 16);
+    return m_mock.device.counters().nacks;
+}
+
+/**
+ * Checks that the adaptive mode learns a write cycle shorter than the maximum one, and then probes far less than the polling mode.
+ */
+static void test_adaptive(void) {
+    uint32_t nacks_polling = write_sequence_nacks(m24c64::WRITE_WAIT_MODE_POLLING);
+    uint32_t nacks_adaptive = write_sequence_nacks(m24c64::WRITE_WAIT_MODE_ADAPTIVE);
+    TEST_ASSERT(nacks_polling >= 16 * 8);
+    TEST_ASSERT(nacks_adaptive < 16 * 2);
+    TEST_ASSERT(nacks_adaptive * 8 < nacks_polling);
+}
+
+/**
+ * Stands for a low power wait, counting how often and for how long it is entered.
+ * @param[in] duration_us The time to sleep for, in microseconds.
+ */
+static void sleep_counting(uint32_t duration_us) {
+    m_sleeps++;
+    m_sleep_duration = duration_us;
+    delayMicroseconds(duration_us);
+}
+
+/**
+ * Checks that the sleep mode sleeps through the learned write cycle time, which gets shorter than the maximum one, then probes the device about once per write.
+ */
+static void test_sleep(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64::WRITE_WAIT_MODE_SLEEP, 0, NULL) == -EINVAL);
+    TEST_ASSERT(m_eeprom.write_wait_setup(m24c64::WRITE_WAIT_MODE_SLEEP, 0, sleep_counting) == 0);
+    for (size_t i = 0; i < 16; i++) {
+        TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    }
+    m_mock.device.counters_reset();
+    m_sleeps = 0;
+    for (size_t i = 0; i < 16; i++) {
+        TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+        TEST_ASSERT(m_eeprom.write_cycle_remaining() > 0);
+    }
+    TEST_ASSERT(m_sleeps == 16);
+    TEST_ASSERT(m_eeprom.read(0, m_check, 1) == 1 && m_check[0] == m_data[0]);
+    TEST_ASSERT(m_sleep_duration > 3000 / 2 && m_sleep_duration < eeprom_i2c_m24c64::duration_write_cycle);
+    TEST_ASSERT(m_mock.device.counters().write_cycles == 16);
+    TEST_ASSERT(m_mock.device.counters().nacks <= 16 / 4);
+    TEST_ASSERT(m_mock.device.counters().transactions <= 16 * 2 + 2 + 16 / 4);
+    TEST_ASSERT(m_eeprom.write_cycle_remaining() == 0);
+}
+
+/**
+ * Checks the remaining write cycle time, which lets a sketch go to sleep right after a write.
+ */
+static void test_remaining(void) {
+    fixture();
+    TEST_ASSERT(m_eeprom.write_cycle_remaining() == 0);
+    TEST_ASSERT(m_eeprom.write(0, m_data, 1) == 1);
+    uint32_t remaining = m_eeprom.write_cycle_remaining();
+    TEST_ASSERT(remaining > 0 && remaining <= eeprom_i2c_m24c64::duration_write_cycle);
+    delay(6);
+    TEST_ASSERT(m_eeprom.write_cycle_remaining() == 0);
+}
+
+int main(void) {
+    TEST_RUN(test_polling);
+    TEST_RUN(test_timeout);
+    TEST_RUN(test_adaptive);
+    TEST_RUN(test_sleep);
+    TEST_RUN(test_remaining);
+    return TEST_RESULT();
+}
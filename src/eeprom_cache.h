@@ -0,0 +1,320 @@
+#ifndef EEPROM_CACHE_H
+#define EEPROM_CACHE_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Ram cache of eeprom pages, placed in front of the read and write functions of an eeprom.
+ * @note Pages are loaded with a single sequential read upon the first access, and evicted with the clock (second chance) algorithm.
+ * @note In write through mode, writes go straight to the eeprom and also update the cached pages.
+ * @note In write back mode, writes only update the cached pages, which are then sent as single page writes when evicted or when sync() is called.
+ * @tparam eeprom The type of the underlying storage, such as eeprom_i2c or eeprom_i2c_bank.
+ * @tparam count The number of pages to keep in ram.
+ */
+template <class eeprom, uint8_t count>
+class eeprom_cache {
+
+   public:
+    enum cache_mode {
+        CACHE_MODE_WRITE_THROUGH,
+        CACHE_MODE_WRITE_BACK,
+    };
+    int setup(eeprom& storage, const enum cache_mode mode);
+    int read(const uint32_t address, uint8_t* const data, const size_t length);
+    int write(const uint32_t address, const uint8_t* const data, const size_t length);
+    int sync(void);
+    int invalidate(void);
+
+    /* Geometry of the underlying storage */
+    static constexpr uint32_t size_total(void) {
+        return eeprom::size_total();
+    }
+    static constexpr uint16_t size_page(void) {
+        return eeprom::size_page();
+    }
+
+   protected:
+    struct line {
+        uint32_t page;
+        bool valid;
+        bool referenced;
+        uint16_t dirty_start;  // Range of bytes that differ from the eeprom, empty when start and end are equal
+        uint16_t dirty_end;
+        uint8_t data[eeprom::size_page()];
+    };
+    eeprom* m_storage = NULL;
+    enum cache_mode m_mode = CACHE_MODE_WRITE_THROUGH;
+    struct line m_lines[count];
+    uint8_t m_hand = 0;
+    static constexpr size_t m_size_page = eeprom::size_page();
+    struct line* line_find(const uint32_t page);
+    struct line* line_load(const uint32_t page, const bool fetch);
+    int line_clean(struct line& l);
+    static_assert(count > 0, "The cache must hold at least one page");
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom, uint8_t count>
+constexpr size_t eeprom_cache<eeprom, count>::m_size_page;
+
+/**
+ * Configures the cache.
+ * @note Call this from the Arduino setup function, after the eeprom has been setup.
+ * @param[in] storage A reference to the eeprom to use.
+ * @param[in] mode The write policy.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::setup(eeprom& storage, const enum cache_mode mode) {
+
+    /* Ensure mode is valid */
+    if (mode != CACHE_MODE_WRITE_THROUGH && mode != CACHE_MODE_WRITE_BACK) {
+        return -EINVAL;
+    }
+
+    /* Start with an empty cache */
+    m_storage = &storage;
+    m_mode = mode;
+    for (uint8_t i = 0; i < count; i++) {
+        m_lines[i].valid = false;
+    }
+    m_hand = 0;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ *
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::read(const uint32_t address, uint8_t* const data, const size_t length) {
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= size_total()) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > size_total() - address) ? size_total() - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Serve bytes page by page */
+    for (size_t i = 0; i < length_capped;) {
+        uint32_t page = (address + i) / m_size_page;
+        size_t offset = (address + i) % m_size_page;
+        size_t length_chunk = m_size_page - offset;
+        if (length_chunk > length_capped - i) {
+            length_chunk = length_capped - i;
+        }
+        struct line* l = line_load(page, true);
+        if (l == NULL) return -EIO;
+        memcpy(&data[i], &l->data[offset], length_chunk);
+        i += length_chunk;
+    }
+
+    /* Return number of bytes read */
+    return length_capped;
+}
+
+/**
+ *
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::write(const uint32_t address, const uint8_t* const data, const size_t length) {
+    int res;
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= size_total()) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > size_total() - address) ? size_total() - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* In write through mode, write eeprom first, then update cached pages */
+    if (m_mode == CACHE_MODE_WRITE_THROUGH) {
+        res = m_storage->write(address, data, length_capped);
+        if (res < 0) {
+            return res;
+        }
+        length_capped = res;
+    }
+
+    /* Update cached pages, loading them in write back mode unless they are fully overwritten */
+    for (size_t i = 0; i < length_capped;) {
+        uint32_t page = (address + i) / m_size_page;
+        size_t offset = (address + i) % m_size_page;
+        size_t length_chunk = m_size_page - offset;
+        if (length_chunk > length_capped - i) {
+            length_chunk = length_capped - i;
+        }
+        struct line* l;
+        if (m_mode == CACHE_MODE_WRITE_THROUGH) {
+            l = line_find(page);
+        } else {
+            l = line_load(page, length_chunk != m_size_page);
+            if (l == NULL) return -EIO;
+        }
+        if (l != NULL) {
+            memcpy(&l->data[offset], &data[i], length_chunk);
+            if (m_mode == CACHE_MODE_WRITE_BACK) {
+                if (l->dirty_start == l->dirty_end) {
+                    l->dirty_start = offset;
+                    l->dirty_end = offset + length_chunk;
+                } else {
+                    if (offset < l->dirty_start) l->dirty_start = offset;
+                    if (offset + length_chunk > l->dirty_end) l->dirty_end = offset + length_chunk;
+                }
+            }
+        }
+        i += length_chunk;
+    }
+
+    /* Return number of bytes written */
+    return length_capped;
+}
+
+/**
+ * Writes all dirty pages to the eeprom.
+ * @note Only useful in write back mode. Call this before powering down for example.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::sync(void) {
+    int res;
+    for (uint8_t i = 0; i < count; i++) {
+        res = line_clean(m_lines[i]);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Writes all dirty pages to the eeprom, then drops all cached pages.
+ * @note Call this if the eeprom has been modified without going through the cache.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::invalidate(void) {
+    int res = sync();
+    if (res < 0) {
+        return res;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        m_lines[i].valid = false;
+    }
+    return 0;
+}
+
+/**
+ * Looks up a page in the cache.
+ * @param[in] page The index of the page.
+ * @return A pointer to the line holding the page, or NULL if it isn't cached.
+ */
+template <class eeprom, uint8_t count>
+typename eeprom_cache<eeprom, count>::line* eeprom_cache<eeprom, count>::line_find(const uint32_t page) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (m_lines[i].valid && m_lines[i].page == page) {
+            m_lines[i].referenced = true;
+            return &m_lines[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Gets the line holding a page, evicting another page if needed.
+ * @param[in] page The index of the page.
+ * @param[in] fetch true to read the content of the page from the eeprom, false if it is about to be fully overwritten.
+ * @return A pointer to the line holding the page, or NULL in case of failure.
+ */
+template <class eeprom, uint8_t count>
+typename eeprom_cache<eeprom, count>::line* eeprom_cache<eeprom, count>::line_load(const uint32_t page, const bool fetch) {
+
+    /* Cache hit */
+    struct line* l = line_find(page);
+    if (l != NULL) {
+        return l;
+    }
+
+    /* Pick a victim with the clock algorithm: invalid lines first, then lines not referenced since the last sweep */
+    for (;;) {
+        l = &m_lines[m_hand];
+        m_hand = (m_hand + 1) % count;
+        if (l->valid == false) {
+            break;
+        } else if (l->referenced == true) {
+            l->referenced = false;
+        } else {
+            break;
+        }
+    }
+
+    /* Evict it */
+    if (line_clean(*l) < 0) {
+        return NULL;
+    }
+    l->valid = false;
+
+    /* Load page in it */
+    if (fetch) {
+        int res = m_storage->read(page * m_size_page, l->data, m_size_page);
+        if (res < 0 || (size_t)res != m_size_page) {
+            return NULL;
+        }
+    }
+    l->page = page;
+    l->valid = true;
+    l->referenced = true;
+    l->dirty_start = 0;
+    l->dirty_end = fetch ? 0 : m_size_page;
+    return l;
+}
+
+/**
+ * Writes the dirty bytes of a line to the eeprom, as a single page write.
+ * @param[in] l The line.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint8_t count>
+int eeprom_cache<eeprom, count>::line_clean(struct line& l) {
+    if (l.valid == false || l.dirty_start == l.dirty_end) {
+        return 0;
+    }
+    size_t length = l.dirty_end - l.dirty_start;
+    int res = m_storage->write(l.page * m_size_page + l.dirty_start, &l.data[l.dirty_start], length);
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != length) {
+        return -EIO;
+    }
+    l.dirty_start = l.dirty_end = 0;
+    return 0;
+}
+
+#endif
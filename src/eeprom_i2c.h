@@ -0,0 +1,2250 @@
+#ifndef EEPROM_I2C_H
+#define EEPROM_I2C_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Stream.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Optional features, which are all built in unless EEPROM_I2C_SLIM is defined as a build flag
+ * The slim profile leaves out their code and the ram each instance holds for them, and each one can then be brought back with its own build flag:
+ * - EEPROM_I2C_ASYNC for write_async() and read_async(), 20 bytes on AVR, transport included, and required by eeprom_i2c_bank and eeprom_rtos,
+ * - EEPROM_I2C_CLOCK for clock_setup(), 10 bytes on AVR,
+ * - EEPROM_I2C_SLEEP for the sleep write wait mode, 2 bytes on AVR,
+ * - EEPROM_I2C_COMPARE for write_compare_setup(), 1 byte,
+ * - EEPROM_I2C_IDENTIFICATION_CACHE to keep the identification page in ram, the size of the page plus 1 byte, or 2 bytes for devices without one, identification_read() going to the device every time without it.
+ * The flags must be the same for all the files of a program, and are seen by the transports too. */
+#if !defined(EEPROM_I2C_SLIM)
+#if !defined(EEPROM_I2C_ASYNC)
+#define EEPROM_I2C_ASYNC
+#endif
+#if !defined(EEPROM_I2C_CLOCK)
+#define EEPROM_I2C_CLOCK
+#endif
+#if !defined(EEPROM_I2C_SLEEP)
+#define EEPROM_I2C_SLEEP
+#endif
+#if !defined(EEPROM_I2C_COMPARE)
+#define EEPROM_I2C_COMPARE
+#endif
+#if !defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+#define EEPROM_I2C_IDENTIFICATION_CACHE
+#endif
+#endif
+
+/* Default transport */
+#include "eeprom_i2c_wire.h"
+
+/* Descriptors of supported devices */
+#include "eeprom_i2c_parts.h"
+
+/* Project code */
+#include "eeprom_crc.h"
+
+/**
+ * Statistics gathered by the driver when EEPROM_I2C_STATS is defined as a build flag.
+ * @note Without the build flag, neither the statistics nor the hooks take any space or time.
+ */
+#if defined(EEPROM_I2C_STATS)
+struct eeprom_i2c_stats {
+    uint32_t transactions;   // Bus transactions of any kind
+    uint32_t bytes_read;     // Data bytes read
+    uint32_t bytes_written;  // Data bytes written
+    uint32_t writes_page;    // Write transactions of more than one data byte
+    uint32_t writes_byte;    // Write transactions of a single data byte, each one costing a write cycle
+    uint32_t polls;          // Probes of the device while waiting for a write cycle to complete
+    uint32_t duration_wait;  // Time spent blocked waiting for write cycles to complete, in microseconds
+    uint32_t errors;         // Transactions that failed with -EIO
+};
+#endif
+
+/**
+ * Segment of ram for vectored reads and writes.
+ */
+struct eeprom_i2c_segment {
+    uint8_t* data;
+    size_t length;
+};
+struct eeprom_i2c_segment_const {
+    const uint8_t* data;
+    size_t length;
+};
+
+/**
+ * Range of bytes to read as part of a batch.
+ */
+struct eeprom_i2c_request {
+    uint32_t address;
+    uint8_t* data;
+    size_t length;
+};
+
+/**
+ * Core of the driver for i2c eeproms, with the geometry of the device given by a descriptor, and without the stream interface.
+ * @note It holds no buffer nor virtual function, so that small mcus only pay for the functions they call. Use eeprom_i2c for the stream interface.
+ * @note Its ram use is a few tens of bytes of state, the geometry being compile time constants. The stream interface adds a vtable, which pulls all stream functions into flash, the two indexes, the read ahead state and a write buffer of up to a page.
+ * @note On AVR, an m24c64_core holds 57 bytes, and 22 bytes with EEPROM_I2C_SLIM defined. These figures add up the sizes of the members, with 2 byte pointers, ints and enums and no padding, rather than being measured on a board, so check them with examples/Footprint.
+ * @see examples/Footprint to measure the flash and ram use of both on a given board.
+ * @see eeprom_i2c_parts.h for the list of supported devices.
+ * @tparam descriptor The descriptor of the device.
+ * @tparam transport The transport to the bus.
+ * @tparam adapter The class built on top of the core that keeps ram buffers of its own, such as eeprom_i2c, or void.
+ */
+template <class descriptor, class transport = eeprom_i2c_wire, class adapter = void>
+class eeprom_i2c_core {
+
+   public:
+    enum write_wait_mode {
+        WRITE_WAIT_MODE_POLLING,
+        WRITE_WAIT_MODE_TIMEOUT,
+        WRITE_WAIT_MODE_ADAPTIVE,
+        WRITE_WAIT_MODE_SLEEP,
+    };
+    enum clock_mode {
+        CLOCK_MODE_FIXED,
+        CLOCK_MODE_BULK,
+    };
+    int setup(typename transport::bus& i2c_library, const uint8_t i2c_address);
+    bool detect(void);
+#if defined(EEPROM_I2C_CLOCK)
+    int clock_setup(const uint32_t frequency_bus, const enum clock_mode mode, const uint32_t frequency_limit = descriptor::frequency_max);
+    uint32_t clock_frequency(void);
+#endif
+    int write_wait_setup(const enum write_wait_mode mode, const uint32_t poll_interval_us = 0, void (*sleep)(uint32_t duration_us) = NULL);
+    uint32_t write_cycle_remaining(void);
+#if defined(EEPROM_I2C_COMPARE)
+    int write_compare_setup(const bool enabled);
+#endif
+    int read(const uint32_t address, uint8_t* const data, const size_t length);
+    int read_to(const uint32_t address, const size_t length, Print& sink);
+    int read_to(const uint32_t address, const size_t length, void (*callback)(const uint8_t* data, size_t length, void* context), void* context = NULL);
+    int write(const uint32_t address, const uint8_t* const data, const size_t length);
+    int read_block(const uint32_t address, uint8_t* const data, const size_t length);
+    int write_block(const uint32_t address, const uint8_t* const data, const size_t length);
+    int readv(const uint32_t address, const struct eeprom_i2c_segment* const segments, const size_t count);
+    int writev(const uint32_t address, const struct eeprom_i2c_segment_const* const segments, const size_t count);
+    int read_batch(struct eeprom_i2c_request* const requests, const size_t count, const size_t gap_max = 4);
+    template <class T>
+    int get(const uint32_t address, T& object);
+    template <class T>
+    int put(const uint32_t address, const T& object);
+    int copy(const uint32_t address_source, const uint32_t address_destination, const size_t length);
+    template <class eeprom>
+    int copy_to(eeprom& destination, const uint32_t address_source, const uint32_t address_destination, const size_t length);
+    int fill(const uint32_t address, const uint8_t value, const size_t length);
+    int erase(void);
+#if defined(EEPROM_I2C_ASYNC)
+    int write_async(const uint32_t address, const uint8_t* const data, const size_t length, void (*callback)(int res) = NULL);
+    int write_async_poll(void);
+    int read_async(const uint32_t address, uint8_t* const data, const size_t length, void (*callback)(int res) = NULL);
+    int read_async_poll(void);
+#endif
+    int identification_read(const uint8_t address, uint8_t* const data, const size_t length);
+    int identification_write(const uint8_t address, const uint8_t* const data, const size_t length);
+    int identification_lock(void);
+    int identification_locked(bool& locked);
+#if defined(EEPROM_I2C_STATS)
+    const struct eeprom_i2c_stats& stats(void);
+    void stats_reset(void);
+    void stats_hooks(void (*begin)(uint8_t i2c_address, void* context), void (*end)(uint8_t i2c_address, int res, void* context), void* context = NULL);
+#endif
+
+    /* Geometry of the device */
+    static constexpr uint32_t size_total(void) {
+        return descriptor::size_total;
+    }
+    static constexpr uint16_t size_page(void) {
+        return descriptor::size_page;
+    }
+
+    /* Number of transactions a write takes, which can be checked at compile time for a constant address and length */
+    static constexpr size_t write_transactions(const uint32_t address, const size_t length) {
+        return (length == 0) ? 0 : 1 + write_transactions(address + write_transaction_length(address, length), length - write_transaction_length(address, length));
+    }
+
+    /* Number of bytes of the next transaction of a write, which neither crosses a page boundary nor overflows the bus buffer */
+    static constexpr size_t write_transaction_length(const uint32_t address, const size_t length) {
+        return smallest(smallest(descriptor::size_page - (address % descriptor::size_page), transport::size_write_max() - descriptor::address_width), length);
+    }
+
+   protected:
+    static constexpr size_t smallest(const size_t a, const size_t b) {
+        return (a < b) ? a : b;
+    }
+    transport m_transport;
+    uint8_t m_i2c_address;
+    static constexpr uint32_t m_size_total = descriptor::size_total;
+    static constexpr uint16_t m_size_page = descriptor::size_page;
+    static constexpr uint8_t m_address_width = descriptor::address_width;
+    static constexpr uint32_t m_size_block = 1UL << (8 * descriptor::address_width);  // Span of the memory address bytes
+    static constexpr uint8_t m_mask_block = (1 << descriptor::address_block_bits) - 1;
+    static constexpr uint32_t m_duration_write_cycle = descriptor::duration_write_cycle;
+    static constexpr size_t m_size_write_max = transport::size_write_max() - descriptor::address_width;  // Data bytes in a single write transaction
+    static constexpr size_t m_size_read_max = transport::size_read_max();
+    static constexpr size_t m_size_write_buffer = (descriptor::size_page < m_size_write_max) ? descriptor::size_page : m_size_write_max;
+    static constexpr uint8_t m_i2c_address_identification = 0x58;  // Device type identifier of the identification page, completed with the chip enable bits
+    static constexpr uint32_t m_address_identification_lock = 0x0400;
+    uint32_t m_timestamp_write = 0;
+    bool m_write_pending = false;
+    enum write_wait_mode m_write_wait_mode = WRITE_WAIT_MODE_POLLING;
+    uint32_t m_write_wait_poll_interval = 0;
+    uint32_t m_write_wait_learned = descriptor::duration_write_cycle;
+#if defined(EEPROM_I2C_SLEEP)
+    void (*m_write_wait_sleep)(uint32_t duration_us) = NULL;
+#endif
+    uint32_t m_timestamp_probe = 0;
+#if defined(EEPROM_I2C_COMPARE)
+    bool m_write_compare = false;
+#endif
+#if defined(EEPROM_I2C_CLOCK)
+    enum clock_mode m_clock_mode = CLOCK_MODE_FIXED;
+    uint32_t m_clock_bus = 0;
+    uint32_t m_clock_fast = 0;  // Negotiated clock frequency, or 0 to leave the bus clock alone
+#endif
+#if defined(EEPROM_I2C_ASYNC)
+    uint32_t m_async_address = 0;
+    const uint8_t* m_async_data = NULL;
+    size_t m_async_length = 0;
+    size_t m_async_index = 0;
+    void (*m_async_callback)(int res) = NULL;
+    uint8_t* m_async_destination = NULL;  // Buffer of the read in progress, NULL if the one in progress is a write
+    enum async_phase {
+        ASYNC_PHASE_NONE,    // No transfer in flight
+        ASYNC_PHASE_WRITE,   // Page write
+        ASYNC_PHASE_HEADER,  // Memory address of a read
+        ASYNC_PHASE_READ,    // Data of a read
+    };
+    enum async_phase m_async_phase = ASYNC_PHASE_NONE;
+    uint8_t m_async_i2c_address = 0;  // Device address of the transfer in flight
+    bool m_async_seek = false;        // Whether the read in progress must send its memory address before its next chunk
+#endif
+    struct read_block_context {
+        uint8_t* data;
+        size_t length;
+        size_t index;
+        uint16_t crc;
+        uint8_t crc_stored[2];
+    };
+    struct read_batch_context {
+        const struct eeprom_i2c_request* requests;
+        size_t count;
+        uint32_t address;
+    };
+    struct readv_context {
+        const struct eeprom_i2c_segment* segments;
+        size_t segment;
+        size_t offset;
+    };
+#if defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+    uint8_t m_identification[(descriptor::size_identification > 0) ? descriptor::size_identification : 1];
+    bool m_identification_cached = false;
+#endif
+#if defined(EEPROM_I2C_STATS)
+    struct eeprom_i2c_stats m_stats = {};
+    void (*m_stats_hook_begin)(uint8_t i2c_address, void* context) = NULL;
+    void (*m_stats_hook_end)(uint8_t i2c_address, int res, void* context) = NULL;
+    void* m_stats_hook_context = NULL;
+#endif
+    void write_wait(void);
+    bool write_wait_check(void);
+    int write_prepare(const uint32_t address, const size_t length);
+    /* Hooks to keep the buffers of the adapter coherent, the first one being picked at compile time when there is no adapter */
+    int adapter_coherence(void*, const uint32_t, const size_t, const bool) {
+        return 0;
+    }
+    template <class T>
+    int adapter_coherence(T*, const uint32_t address, const size_t length, const bool write) {
+        return static_cast<T*>(this)->coherence(address, length, write);
+    }
+    int write_page(const uint32_t address, const uint8_t* const data, const size_t length);
+    int write_transaction(const uint8_t i2c_address, const uint32_t address, const uint8_t* const data, const size_t length);
+    int write_transaction_end(const uint8_t i2c_address, const int length_written);
+#if defined(EEPROM_I2C_ASYNC)
+    int async_transfer_end(const int res);
+    void async_transfer_finish(const bool seek);
+#else
+    void async_transfer_finish(const bool) {
+    }
+#endif
+    uint8_t i2c_address_for(const uint32_t address);
+    size_t i2c_address_header(const uint32_t address, uint8_t* const header);
+    void clock_raise(void);
+    void clock_restore(void);
+    void stats_begin(const uint8_t i2c_address);
+    void stats_end(const uint8_t i2c_address, const int res);
+    int read_engine(const uint32_t address, uint8_t* const data, const size_t length, void (*callback)(const uint8_t* data, size_t length, void* context), void* context);
+    static void read_to_print(const uint8_t* data, size_t length, void* context);
+    static void read_block_chunk(const uint8_t* data, size_t length, void* context);
+    static void readv_chunk(const uint8_t* data, size_t length, void* context);
+    static void read_batch_chunk(const uint8_t* data, size_t length, void* context);
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class descriptor, class transport, class adapter>
+constexpr uint32_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_total;
+template <class descriptor, class transport, class adapter>
+constexpr uint16_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_page;
+template <class descriptor, class transport, class adapter>
+constexpr uint8_t eeprom_i2c_core<descriptor, transport, adapter>::m_address_width;
+template <class descriptor, class transport, class adapter>
+constexpr uint32_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_block;
+template <class descriptor, class transport, class adapter>
+constexpr uint8_t eeprom_i2c_core<descriptor, transport, adapter>::m_mask_block;
+template <class descriptor, class transport, class adapter>
+constexpr uint32_t eeprom_i2c_core<descriptor, transport, adapter>::m_duration_write_cycle;
+template <class descriptor, class transport, class adapter>
+constexpr size_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_write_max;
+template <class descriptor, class transport, class adapter>
+constexpr size_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_read_max;
+template <class descriptor, class transport, class adapter>
+constexpr size_t eeprom_i2c_core<descriptor, transport, adapter>::m_size_write_buffer;
+template <class descriptor, class transport, class adapter>
+constexpr uint8_t eeprom_i2c_core<descriptor, transport, adapter>::m_i2c_address_identification;
+template <class descriptor, class transport, class adapter>
+constexpr uint32_t eeprom_i2c_core<descriptor, transport, adapter>::m_address_identification_lock;
+
+/**
+ * Configures the driver with access over I2C.
+ * @note Call this from the Arduino setup function.
+ * @note Make sure the I2C library has been initialized with a call to its begin function for example.
+ * @param[in] i2c_library A reference to the i2c library to use, a TwoWire with the default transport.
+ * @param[in] i2c_address The i2c address of the device.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::setup(typename transport::bus& i2c_library, const uint8_t i2c_address) {
+
+    /* Ensure i2c address is within valid range, and leaves room for the memory address bits it carries */
+    if ((i2c_address & 0xF8) != 0x50 || (i2c_address & m_mask_block) != 0) {
+        return -EINVAL;
+    }
+
+    /* Enable i2c */
+    int res = m_transport.setup(i2c_library);
+    if (res < 0) {
+        return res;
+    }
+    m_i2c_address = i2c_address;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Tries to detect the device.
+ * @return true if the device has been detected, or false otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+bool eeprom_i2c_core<descriptor, transport, adapter>::detect(void) {
+    if (m_transport.ready()) {
+        async_transfer_finish(true);
+        stats_begin(m_i2c_address);
+        bool acknowledged = m_transport.probe(m_i2c_address);
+        stats_end(m_i2c_address, acknowledged ? 0 : -EBUSY);
+        return acknowledged;
+    }
+    return false;
+}
+
+#if defined(EEPROM_I2C_CLOCK)
+/**
+ * Selects the fastest i2c clock frequency supported by both the device and the bus.
+ * @note Call this after setup, with the bus running at its usual clock frequency.
+ * @note Frequencies of 1 MHz, 400 kHz and 100 kHz are tried from the fastest, each one being checked by detecting the device and reading back the first bytes, which must match a reference read at the bus clock frequency.
+ * @note In fixed mode, the bus is left at the selected frequency. In bulk mode, it is only raised for the duration of each read or page write, then restored, so that slower devices on the same bus are unaffected.
+ * @note A frequency no faster than the bus one leaves the bus clock alone.
+ * @param[in] frequency_bus The clock frequency the bus is running at, in Hz, as the i2c library can't report it.
+ * @param[in] mode When to run the bus at the selected frequency.
+ * @param[in] frequency_limit An optional upper limit, for buses whose wiring or other devices can't go as fast as the device.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::clock_setup(const uint32_t frequency_bus, const enum clock_mode mode, const uint32_t frequency_limit) {
+    static const uint32_t frequencies[] = {1000000, 400000, 100000};
+    uint8_t reference[16], test[16];
+    const size_t length = (sizeof(reference) < m_size_total) ? sizeof(reference) : m_size_total;
+    int res;
+
+    /* Ensure setup has been performed and parameters are valid */
+    if (m_transport.ready() == false) {
+        return -EINVAL;
+    }
+    if (frequency_bus == 0 || (mode != CLOCK_MODE_FIXED && mode != CLOCK_MODE_BULK)) {
+        return -EINVAL;
+    }
+
+    /* Go back to the bus clock frequency, and read the reference bytes with it */
+    async_transfer_finish(false);
+    if (m_clock_fast != 0 && m_clock_mode == CLOCK_MODE_FIXED) {
+        m_transport.clock(m_clock_bus);
+    }
+    m_clock_fast = 0;
+    res = read(0, reference, length);
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != length) {
+        return -EIO;
+    }
+
+    /* Try frequencies from the fastest */
+    uint32_t frequency_selected = 0;
+    for (size_t i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+        if (frequencies[i] > descriptor::frequency_max || frequencies[i] > frequency_limit || frequencies[i] <= frequency_bus) {
+            continue;
+        }
+        res = m_transport.clock(frequencies[i]);
+        if (res < 0) {
+            continue;
+        }
+        if (detect() == true && read(0, test, length) == (int)length && memcmp(reference, test, length) == 0) {
+            frequency_selected = frequencies[i];
+            break;
+        }
+    }
+
+    /* Leave the bus at the selected frequency in fixed mode only */
+    if (frequency_selected == 0 || mode == CLOCK_MODE_BULK) {
+        m_transport.clock(frequency_bus);
+    }
+    m_clock_mode = mode;
+    m_clock_bus = frequency_bus;
+    m_clock_fast = frequency_selected;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Gets the clock frequency used for transfers with the device.
+ * @return The frequency selected by clock_setup() in Hz, or 0 if the bus clock frequency is used.
+ */
+template <class descriptor, class transport, class adapter>
+uint32_t eeprom_i2c_core<descriptor, transport, adapter>::clock_frequency(void) {
+    return m_clock_fast;
+}
+#endif
+
+/**
+ * In bulk mode, switches the bus to the negotiated clock frequency before a transfer.
+ * @note The transfer in flight of a non blocking write or read, if any, is completed first, as it restores the clock when it ends.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::clock_raise(void) {
+    async_transfer_finish(false);
+#if defined(EEPROM_I2C_CLOCK)
+    if (m_clock_fast != 0 && m_clock_mode == CLOCK_MODE_BULK) {
+        m_transport.clock(m_clock_fast);
+    }
+#endif
+}
+
+/**
+ * In bulk mode, switches the bus back to its usual clock frequency after a transfer.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::clock_restore(void) {
+#if defined(EEPROM_I2C_CLOCK)
+    if (m_clock_fast != 0 && m_clock_mode == CLOCK_MODE_BULK) {
+        m_transport.clock(m_clock_bus);
+    }
+#endif
+}
+
+#if defined(EEPROM_I2C_STATS)
+/**
+ * Gets the statistics gathered since setup or since the last reset.
+ * @return A reference to the statistics.
+ */
+template <class descriptor, class transport, class adapter>
+const struct eeprom_i2c_stats& eeprom_i2c_core<descriptor, transport, adapter>::stats(void) {
+    return m_stats;
+}
+
+/**
+ * Sets all statistics back to zero.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::stats_reset(void) {
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/**
+ * Registers functions called around each bus transaction, to trace or time them.
+ * @note The functions are called from within the driver, and must neither block nor access the device.
+ * @param[in] begin An optional function called right before a transaction starts, or NULL.
+ * @param[in] end An optional function called right after a transaction ends, with the number of data bytes transferred or a negative error code, or NULL.
+ * @param[in] context An optional pointer passed as is to the functions.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::stats_hooks(void (*begin)(uint8_t i2c_address, void* context), void (*end)(uint8_t i2c_address, int res, void* context), void* context) {
+    m_stats_hook_begin = begin;
+    m_stats_hook_end = end;
+    m_stats_hook_context = context;
+}
+#endif
+
+/**
+ * Marks the start of a bus transaction, for statistics.
+ * @note Does nothing unless EEPROM_I2C_STATS is defined.
+ * @param[in] i2c_address
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::stats_begin(const uint8_t i2c_address) {
+#if defined(EEPROM_I2C_STATS)
+    if (m_stats_hook_begin != NULL) {
+        m_stats_hook_begin(i2c_address, m_stats_hook_context);
+    }
+#else
+    (void)i2c_address;
+#endif
+}
+
+/**
+ * Marks the end of a bus transaction, for statistics.
+ * @note Does nothing unless EEPROM_I2C_STATS is defined.
+ * @param[in] i2c_address
+ * @param[in] res The number of data bytes transferred, or a negative error code.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::stats_end(const uint8_t i2c_address, const int res) {
+#if defined(EEPROM_I2C_STATS)
+    m_stats.transactions++;
+    if (res == -EIO) {
+        m_stats.errors++;
+    }
+    if (m_stats_hook_end != NULL) {
+        m_stats_hook_end(i2c_address, res, m_stats_hook_context);
+    }
+#else
+    (void)i2c_address;
+    (void)res;
+#endif
+}
+
+#if defined(EEPROM_I2C_COMPARE)
+/**
+ * Enables or disables the compare before write mode.
+ * @note When enabled, write() first reads the bytes it is about to overwrite, and only writes the part of each page that actually differs.
+ * @note This trades a fast read for a write cycle, and saves endurance, when rewriting data that rarely changes.
+ * @param[in] enabled true to enable the mode, false to disable it.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_compare_setup(const bool enabled) {
+    m_write_compare = enabled;
+    return 0;
+}
+#endif
+
+/**
+ * Computes the i2c address to use to reach the given memory address.
+ * @note Devices with more memory than their address bytes can reach carry the upper bits in the device address.
+ * @param[in] address
+ * @return The i2c address.
+ */
+template <class descriptor, class transport, class adapter>
+uint8_t eeprom_i2c_core<descriptor, transport, adapter>::i2c_address_for(const uint32_t address) {
+    return m_i2c_address | ((address / m_size_block) & m_mask_block);
+}
+
+/**
+ * Builds the memory address bytes that start a transaction.
+ * @param[in] address
+ * @param[out] header A buffer of at least two bytes to store the address bytes.
+ * @return The number of address bytes.
+ */
+template <class descriptor, class transport, class adapter>
+size_t eeprom_i2c_core<descriptor, transport, adapter>::i2c_address_header(const uint32_t address, uint8_t* const header) {
+    size_t i = 0;
+    if (m_address_width > 1) {
+        header[i++] = (uint8_t)(address >> 8);
+    }
+    header[i++] = (uint8_t)(address >> 0);
+    return i;
+}
+
+/**
+ * Configures how the driver waits for the completion of internal write cycles.
+ * @note In polling mode, the device is probed until it acknowledges, or until the maximum write cycle time has elapsed.
+ * @note In timeout mode, the bus is left alone for the maximum write cycle time.
+ * @note In adaptive mode, the bus is left alone for the write cycle time learned from previous completions, then the device is probed.
+ * @note In sleep mode, the rest of the learned write cycle time is handed over to the sleep function, then the device is probed, usually only once. It is only available when EEPROM_I2C_SLEEP is built in.
+ * @param[in] mode The strategy to use.
+ * @param[in] poll_interval_us The delay between two probes of the device, in microseconds.
+ * @param[in] sleep In sleep mode, a function that puts the mcu in a low power state for about the given duration, such as an idle mode woken up by a timer.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_wait_setup(const enum write_wait_mode mode, const uint32_t poll_interval_us, void (*sleep)(uint32_t duration_us)) {
+
+    /* Ensure mode is valid */
+    if (mode != WRITE_WAIT_MODE_POLLING && mode != WRITE_WAIT_MODE_TIMEOUT && mode != WRITE_WAIT_MODE_ADAPTIVE && mode != WRITE_WAIT_MODE_SLEEP) {
+        return -EINVAL;
+    }
+#if defined(EEPROM_I2C_SLEEP)
+    if (mode == WRITE_WAIT_MODE_SLEEP && sleep == NULL) {
+        return -EINVAL;
+    }
+#else
+    if (mode == WRITE_WAIT_MODE_SLEEP) {
+        return -ENOTSUP;
+    }
+    (void)sleep;
+#endif
+
+    /* Ensure interval is shorter than a write cycle */
+    if (poll_interval_us >= m_duration_write_cycle) {
+        return -EINVAL;
+    }
+
+    /* Save settings and restart learning */
+    m_write_wait_mode = mode;
+    m_write_wait_poll_interval = poll_interval_us;
+    m_write_wait_learned = m_duration_write_cycle;
+#if defined(EEPROM_I2C_SLEEP)
+    m_write_wait_sleep = sleep;
+#endif
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Waits for the completion of the internal write cycle, if a write has been performed recently.
+ * @note Waiting stops after the maximum write cycle time, in which case the next transaction will report an error if the device is still busy.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::write_wait(void) {
+#if defined(EEPROM_I2C_STATS)
+    uint32_t start = micros();
+#endif
+
+    /* Let the transfer of a non blocking write or read complete */
+    async_transfer_finish(true);
+
+#if defined(EEPROM_I2C_SLEEP)
+    /* Sleep mode: sleep through the rest of the learned write cycle time */
+    if (m_write_wait_mode == WRITE_WAIT_MODE_SLEEP && m_write_pending == true) {
+        uint32_t elapsed = micros() - m_timestamp_write;
+        if (elapsed < m_write_wait_learned) {
+            uint32_t duration = m_write_wait_learned - elapsed;
+            uint32_t before = micros();
+            m_write_wait_sleep(duration);
+
+            /* Some sleep modes stop the timer behind micros(), so account for the time slept */
+            uint32_t slept = micros() - before;
+            if (slept < duration) {
+                m_timestamp_write -= duration - slept;
+                m_timestamp_probe -= duration - slept;
+            }
+        }
+
+        /* Ready at the first probe: try a slightly shorter sleep next time, otherwise poll and sleep a bit longer than measured next time */
+        if (write_wait_check() == true) {
+            m_write_wait_learned -= m_write_wait_learned / 64;
+        } else {
+            while (write_wait_check() == false) {
+            }
+            elapsed = micros() - m_timestamp_write;
+            m_write_wait_learned = (elapsed < m_duration_write_cycle - (m_duration_write_cycle / 16)) ? elapsed + (elapsed / 16) : m_duration_write_cycle;
+        }
+    }
+#endif
+    while (write_wait_check() == false) {
+    }
+#if defined(EEPROM_I2C_STATS)
+    m_stats.duration_wait += micros() - start;
+#endif
+}
+
+/**
+ * Checks without blocking whether the internal write cycle has completed.
+ * @note Depending on the configured strategy, this may probe the device.
+ * @return true if the device is ready to accept a new transaction, or false otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+bool eeprom_i2c_core<descriptor, transport, adapter>::write_wait_check(void) {
+
+    /* Nothing to wait for if no write has been performed */
+    if (m_write_pending == false) {
+        return true;
+    }
+
+    /* Consider the device ready once the maximum write cycle time has elapsed */
+    uint32_t now = micros();
+    uint32_t elapsed = now - m_timestamp_write;
+    if (elapsed >= m_duration_write_cycle) {
+        m_write_pending = false;
+        return true;
+    }
+
+    /* Timeout mode: stay off the bus for a full write cycle */
+    if (m_write_wait_mode == WRITE_WAIT_MODE_TIMEOUT) {
+        return false;
+    }
+
+    /* Adaptive and sleep modes: stay off the bus for most of the learned write cycle time */
+    if (m_write_wait_mode == WRITE_WAIT_MODE_ADAPTIVE || m_write_wait_mode == WRITE_WAIT_MODE_SLEEP) {
+        if (elapsed < m_write_wait_learned - (m_write_wait_learned / 8)) {
+            return false;
+        }
+    }
+
+    /* Respect poll interval */
+    if (m_write_wait_poll_interval > 0 && now - m_timestamp_probe < m_write_wait_poll_interval) {
+        return false;
+    }
+
+    /* Probe device */
+    m_timestamp_probe = now;
+#if defined(EEPROM_I2C_STATS)
+    m_stats.polls++;
+#endif
+    if (detect() == true) {
+        if (m_write_wait_mode == WRITE_WAIT_MODE_ADAPTIVE) {
+            m_write_wait_learned = (uint32_t)(((uint64_t)m_write_wait_learned * 7 + elapsed) / 8);
+        }
+        m_write_pending = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Gets how long the device may still be busy with the internal write cycle of the last write, without touching the bus.
+ * @note Writes return as soon as their last page has been sent, and the device completes its write cycle on its own. So a final write can be issued right before putting the mcu in deep sleep, as long as the device stays powered for this long.
+ * @note Bytes written through the print interface are only sent once flush() has been called.
+ * @return The time left before the maximum write cycle time has elapsed, in microseconds, or 0 if no write cycle is pending.
+ */
+template <class descriptor, class transport, class adapter>
+uint32_t eeprom_i2c_core<descriptor, transport, adapter>::write_cycle_remaining(void) {
+    if (m_write_pending == false) {
+        return 0;
+    }
+    uint32_t elapsed = micros() - m_timestamp_write;
+    if (elapsed >= m_duration_write_cycle) {
+        m_write_pending = false;
+        return 0;
+    }
+    return m_duration_write_cycle - elapsed;
+}
+
+/**
+ *
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read(const uint32_t address, uint8_t* const data, const size_t length) {
+    clock_raise();
+    int res = read_engine(address, data, length, NULL, NULL);
+    clock_restore();
+    return res;
+}
+
+/**
+ * Reads bytes and hands them over to a print object, such as a serial port or a file, without staging them in a large buffer.
+ * @param[in] address
+ * @param[in] length
+ * @param[in] sink The print object to write the bytes to.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_to(const uint32_t address, const size_t length, Print& sink) {
+    uint8_t chunk[m_size_read_max];
+    clock_raise();
+    int res = read_engine(address, chunk, length, read_to_print, &sink);
+    clock_restore();
+    return res;
+}
+
+/**
+ * Reads bytes and hands them over to a function, one i2c chunk at a time, without staging them in a large buffer.
+ * @param[in] address
+ * @param[in] length
+ * @param[in] callback The function to call with each chunk of bytes, which must not keep the pointer it is given.
+ * @param[in] context An optional pointer passed as is to the function.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_to(const uint32_t address, const size_t length, void (*callback)(const uint8_t* data, size_t length, void* context), void* context) {
+    uint8_t chunk[m_size_read_max];
+    if (callback == NULL) {
+        return -EINVAL;
+    }
+    clock_raise();
+    int res = read_engine(address, chunk, length, callback, context);
+    clock_restore();
+    return res;
+}
+
+/**
+ * Hands bytes over to the print object given as context.
+ * @param[in] data
+ * @param[in] length
+ * @param[in] context A pointer to the print object.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::read_to_print(const uint8_t* data, size_t length, void* context) {
+    static_cast<Print*>(context)->write(data, length);
+}
+
+/**
+ * Reads bytes either into a buffer, or through a small chunk buffer handed over to a function.
+ * @param[in] address
+ * @param[out] data The buffer to store the bytes, or a chunk buffer of m_size_read_max bytes when a function is given.
+ * @param[in] length
+ * @param[in] callback The function to call with each chunk of bytes, or NULL to store all bytes in the buffer.
+ * @param[in] context An optional pointer passed as is to the function.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_engine(const uint32_t address, uint8_t* const data, const size_t length, void (*callback)(const uint8_t* data, size_t length, void* context), void* context) {
+    int res;
+
+    /* Ensure setup has been performed */
+    if (m_transport.ready() == false) {
+        return -EINVAL;
+    }
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= m_size_total) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address) ? m_size_total - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Let the adapter commit the bytes it holds for writing, if they overlap with the bytes about to be read */
+    if (adapter_coherence((adapter*)NULL, address, length_capped, false) < 0) {
+        return -EIO;
+    }
+
+    /* Wait a little bit if a write has just been performed */
+    write_wait();
+
+    /* Read bytes in chunks that fit in the i2c buffer
+     * Chunks are current address reads that rely on the device's address auto-increment, the address only being sent at the start of each block */
+    for (size_t i = 0; i < length_capped;) {
+        if (i == 0 || (address + i) % m_size_block == 0) {
+            uint8_t header[2];
+            size_t header_length = i2c_address_header(address + i, header);
+            stats_begin(i2c_address_for(address + i));
+            res = m_transport.write(i2c_address_for(address + i), header, header_length, NULL, 0, false);
+            stats_end(i2c_address_for(address + i), (res < 0) ? -EIO : res);
+            if (res < 0) return -EIO;
+        }
+        size_t length_chunk = length_capped - i;
+        if (length_chunk > m_size_read_max) {
+            length_chunk = m_size_read_max;
+        }
+        if (length_chunk > m_size_block - ((address + i) % m_size_block)) {
+            length_chunk = m_size_block - ((address + i) % m_size_block);
+        }
+        uint8_t* destination = (callback == NULL) ? &data[i] : data;
+        stats_begin(i2c_address_for(address + i));
+        res = m_transport.read(i2c_address_for(address + i), destination, length_chunk);
+        stats_end(i2c_address_for(address + i), (res <= 0) ? -EIO : res);
+#if defined(EEPROM_I2C_STATS)
+        if (res > 0) m_stats.bytes_read += res;
+#endif
+        if (res <= 0) {
+            return i;
+        } else {
+            if (callback != NULL) {
+                callback(data, res, context);
+            }
+            i += res;
+        }
+    }
+
+    /* Return number of bytes read */
+    return length_capped;
+}
+
+/**
+ *
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write(const uint32_t address, const uint8_t* const data, const size_t length) {
+    int res;
+
+    /* Ensure parameters are valid and caches are coherent */
+    res = write_prepare(address, length);
+    if (res < 0) {
+        return res;
+    }
+    size_t length_capped = res;
+
+    /* Write bytes */
+    for (size_t i = 0; i < length_capped;) {
+
+        /* Wait a little bit if a write has just been performed */
+        write_wait();
+
+        /* In compare mode, only write the span of bytes that differ from the ones already stored */
+        size_t length_skipped = 0;
+        size_t length_chunk = write_transaction_length(address + i, length_capped - i);
+#if defined(EEPROM_I2C_COMPARE)
+        if (m_write_compare == true) {
+            uint8_t current[m_size_write_buffer];
+            res = read(address + i, current, length_chunk);
+            if (res < 0) return res;
+            if ((size_t)res != length_chunk) return -EIO;
+            while (length_skipped < length_chunk && current[length_skipped] == data[i + length_skipped]) {
+                length_skipped++;
+            }
+            if (length_skipped == length_chunk) {
+                i += length_chunk;
+                continue;
+            }
+            while (current[length_chunk - 1] == data[i + length_chunk - 1]) {
+                length_chunk--;
+            }
+        }
+#endif
+
+        /* Page write */
+        res = write_page(address + i + length_skipped, &data[i + length_skipped], length_chunk - length_skipped);
+        if (res < 0) return res;
+        if (res == 0) return i;
+        i += length_skipped + res;
+    }
+
+    /* Return number of bytes written */
+    return length_capped;
+}
+
+/**
+ * Reads a block of bytes written with write_block(), and checks its integrity.
+ * @note The bytes and their crc are fetched with a single sequential read, the crc being computed on each chunk as it arrives.
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length The length of the block, without its crc.
+ * @return The length of the block in case of success, -EBADMSG if the crc doesn't match, or another negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_block(const uint32_t address, uint8_t* const data, const size_t length) {
+    uint8_t chunk[m_size_read_max];
+    struct read_block_context context = {data, length, 0, 0xFFFF, {0, 0}};
+
+    /* Ensure the block and its crc fit */
+    if (address >= m_size_total || m_size_total - address < 2 || length > m_size_total - address - 2 || length > INT_MAX - 2) {
+        return -EINVAL;
+    }
+
+    /* Read block and crc */
+    clock_raise();
+    int res = read_engine(address, chunk, length + 2, read_block_chunk, &context);
+    clock_restore();
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != length + 2) {
+        return -EIO;
+    }
+
+    /* Check crc */
+    if (context.crc != (((uint16_t)context.crc_stored[0] << 0) | ((uint16_t)context.crc_stored[1] << 8))) {
+        return -EBADMSG;
+    }
+    return length;
+}
+
+/**
+ * Hands bytes of a block over to the destination buffer, and the ones after it to the stored crc.
+ * @param[in] data
+ * @param[in] length
+ * @param[in] context A pointer to the state of the read.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::read_block_chunk(const uint8_t* data, size_t length, void* context) {
+    struct read_block_context* block = static_cast<struct read_block_context*>(context);
+    size_t length_data = (block->index < block->length) ? block->length - block->index : 0;
+    if (length_data > length) length_data = length;
+    memcpy(&block->data[block->index], data, length_data);
+    block->crc = eeprom_crc16(block->crc, data, length_data);
+    for (size_t i = length_data; i < length; i++) {
+        block->crc_stored[block->index + i - block->length] = data[i];
+    }
+    block->index += length;
+}
+
+/**
+ * Writes a block of bytes followed by its crc, for read_block() to check its integrity.
+ * @note The crc is computed on each page as it is sent, and its two bytes share the page writes of the last bytes of the block.
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length The length of the block, without its crc, which takes two more bytes.
+ * @return The length of the block in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_block(const uint32_t address, const uint8_t* const data, const size_t length) {
+    uint8_t tail[m_size_write_buffer];
+    uint16_t crc = 0xFFFF;
+    int res;
+
+    /* Ensure the block and its crc fit */
+    if (address >= m_size_total || m_size_total - address < 2 || length > m_size_total - address - 2 || length > INT_MAX - 2) {
+        return -EINVAL;
+    }
+    res = write_prepare(address, length + 2);
+    if (res < 0) {
+        return res;
+    }
+
+    /* Write bytes, then the crc along with the last of them */
+    for (size_t i = 0; i < length + 2;) {
+        write_wait();
+        size_t length_chunk = write_transaction_length(address + i, length + 2 - i);
+        size_t length_data = (i >= length) ? 0 : (length - i < length_chunk) ? length - i : length_chunk;
+        if (length_data == length_chunk) {
+            crc = eeprom_crc16(crc, &data[i], length_data);
+            res = write_page(address + i, &data[i], length_chunk);
+        } else {
+            if (length_data > 0) {
+                crc = eeprom_crc16(crc, &data[i], length_data);
+                memcpy(tail, &data[i], length_data);
+            }
+            for (size_t j = length_data; j < length_chunk; j++) {
+                tail[j] = (uint8_t)(crc >> (8 * (i + j - length)));
+            }
+            res = write_page(address + i, tail, length_chunk);
+        }
+        if (res < 0) return res;
+        if ((size_t)res != length_chunk) return -EIO;
+        i += length_chunk;
+    }
+
+    /* Return length of block */
+    return length;
+}
+
+/**
+ * Reads a contiguous range of bytes into several segments of ram.
+ * @note The range is fetched with a single sequential read, as if it were read into a single buffer.
+ * @param[in] address
+ * @param[in] segments The segments to fill, in order.
+ * @param[in] count The number of segments.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::readv(const uint32_t address, const struct eeprom_i2c_segment* const segments, const size_t count) {
+    uint8_t chunk[m_size_read_max];
+    struct readv_context context = {segments, 0, 0};
+
+    /* Compute length of the range */
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].length > INT_MAX - length) {
+            return -EINVAL;
+        }
+        length += segments[i].length;
+    }
+
+    /* Read range */
+    clock_raise();
+    int res = read_engine(address, chunk, length, readv_chunk, &context);
+    clock_restore();
+    return res;
+}
+
+/**
+ * Scatters a chunk of bytes over the segments of a vectored read.
+ * @param[in] data
+ * @param[in] length
+ * @param[in] context A pointer to the state of the read.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::readv_chunk(const uint8_t* data, size_t length, void* context) {
+    struct readv_context* state = static_cast<struct readv_context*>(context);
+    for (size_t i = 0; i < length;) {
+        const struct eeprom_i2c_segment& segment = state->segments[state->segment];
+        size_t length_copied = segment.length - state->offset;
+        if (length_copied > length - i) length_copied = length - i;
+        memcpy(&segment.data[state->offset], &data[i], length_copied);
+        i += length_copied;
+        state->offset += length_copied;
+        if (state->offset == segment.length) {
+            state->segment++;
+            state->offset = 0;
+        }
+    }
+}
+
+/**
+ * Reads many small ranges of bytes scattered over the device, such as parameters at boot.
+ * @note Requests are sorted by address, then those whose gap is small enough are merged into a single sequential read, whose bytes are scattered to the requests.
+ * @note Reading a few unneeded bytes costs less than the address phase of a new random read, hence the default gap.
+ * @param[in,out] requests The ranges to read, which get sorted by address.
+ * @param[in] count The number of requests.
+ * @param[in] gap_max The largest number of unneeded bytes read to merge two requests.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_batch(struct eeprom_i2c_request* const requests, const size_t count, const size_t gap_max) {
+    uint8_t chunk[m_size_read_max];
+    int res = 0;
+
+    /* Ensure all requests are valid */
+    for (size_t i = 0; i < count; i++) {
+        if (requests[i].address >= m_size_total || requests[i].length > m_size_total - requests[i].address) {
+            return -EINVAL;
+        }
+    }
+
+    /* Sort requests by address, with an insertion sort as batches are small and often almost sorted */
+    for (size_t i = 1; i < count; i++) {
+        struct eeprom_i2c_request request = requests[i];
+        size_t j = i;
+        for (; j > 0 && requests[j - 1].address > request.address; j--) {
+            requests[j] = requests[j - 1];
+        }
+        requests[j] = request;
+    }
+
+    /* Read groups of nearby requests */
+    clock_raise();
+    for (size_t first = 0; first < count;) {
+        uint32_t start = requests[first].address;
+        uint32_t end = start + requests[first].length;
+        size_t last = first + 1;
+        while (last < count && (requests[last].address <= end || requests[last].address - end <= gap_max)) {
+            if (requests[last].address + requests[last].length > end) {
+                end = requests[last].address + requests[last].length;
+            }
+            last++;
+        }
+        if (end - start > INT_MAX) {
+            res = -EINVAL;
+            break;
+        }
+        struct read_batch_context context = {&requests[first], last - first, start};
+        res = (end > start) ? read_engine(start, chunk, end - start, read_batch_chunk, &context) : 0;
+        if (res < 0) {
+            break;
+        } else if ((uint32_t)res != end - start) {
+            res = -EIO;
+            break;
+        }
+        res = 0;
+        first = last;
+    }
+    clock_restore();
+
+    /* Return result */
+    return res;
+}
+
+/**
+ * Hands a chunk of a merged read over to the requests it overlaps.
+ * @param[in] data
+ * @param[in] length
+ * @param[in] context A pointer to the state of the read.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::read_batch_chunk(const uint8_t* data, size_t length, void* context) {
+    struct read_batch_context* state = static_cast<struct read_batch_context*>(context);
+    uint32_t chunk_start = state->address, chunk_end = state->address + length;
+    for (size_t i = 0; i < state->count; i++) {
+        const struct eeprom_i2c_request& request = state->requests[i];
+        uint32_t start = (request.address > chunk_start) ? request.address : chunk_start;
+        uint32_t end = (request.address + request.length < chunk_end) ? request.address + request.length : chunk_end;
+        if (start < end) {
+            memcpy(&request.data[start - request.address], &data[start - chunk_start], end - start);
+        }
+    }
+    state->address = chunk_end;
+}
+
+/**
+ * Writes several segments of ram to a contiguous range of bytes.
+ * @note Segments are merged into page writes as if they were a single buffer. Page writes that lie within a segment are sent straight from it, and only those straddling segments are gathered in a buffer no larger than a page.
+ * @note The compare before write mode doesn't apply.
+ * @param[in] address
+ * @param[in] segments The segments to write, in order.
+ * @param[in] count The number of segments.
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::writev(const uint32_t address, const struct eeprom_i2c_segment_const* const segments, const size_t count) {
+    uint8_t gather[m_size_write_buffer];
+    int res;
+
+    /* Compute length of the range */
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].length > INT_MAX - length) {
+            return -EINVAL;
+        }
+        length += segments[i].length;
+    }
+
+    /* Ensure parameters are valid and caches are coherent */
+    res = write_prepare(address, length);
+    if (res < 0) {
+        return res;
+    }
+    size_t length_capped = res;
+
+    /* Write bytes */
+    size_t segment = 0, offset = 0;
+    for (size_t i = 0; i < length_capped;) {
+        write_wait();
+
+        /* Skip empty segments */
+        while (segments[segment].length == offset) {
+            segment++;
+            offset = 0;
+        }
+
+        /* Page write, straight from the segment if it holds the whole chunk, otherwise gathered from the following ones */
+        size_t length_chunk = write_transaction_length(address + i, length_capped - i);
+        if (segments[segment].length - offset >= length_chunk) {
+            res = write_page(address + i, &segments[segment].data[offset], length_chunk);
+        } else {
+            size_t s = segment, o = offset;
+            for (size_t j = 0; j < length_chunk;) {
+                size_t length_copied = segments[s].length - o;
+                if (length_copied > length_chunk - j) length_copied = length_chunk - j;
+                memcpy(&gather[j], &segments[s].data[o], length_copied);
+                j += length_copied;
+                s++;
+                o = 0;
+            }
+            res = write_page(address + i, gather, length_chunk);
+        }
+        if (res < 0) return res;
+        if (res == 0) return i;
+
+        /* Move forward in segments */
+        i += res;
+        for (size_t remaining = res; remaining > 0;) {
+            size_t length_skipped = segments[segment].length - offset;
+            if (length_skipped > remaining) length_skipped = remaining;
+            offset += length_skipped;
+            remaining -= length_skipped;
+            if (offset == segments[segment].length && remaining > 0) {
+                segment++;
+                offset = 0;
+            }
+        }
+    }
+
+    /* Return number of bytes written */
+    return length_capped;
+}
+
+/**
+ * Reads an object, such as a structure holding settings.
+ * @note The object is read with a single sequential read of its size.
+ * @param[in] address
+ * @param[out] object
+ * @return The size of the object in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+template <class T>
+int eeprom_i2c_core<descriptor, transport, adapter>::get(const uint32_t address, T& object) {
+    static_assert(__is_trivially_copyable(T), "Only trivially copyable objects can be stored");
+    static_assert(sizeof(T) <= descriptor::size_total && sizeof(T) <= INT_MAX, "The object doesn't fit in the device");
+    if (address > m_size_total - sizeof(T)) {
+        return -EINVAL;
+    }
+    int res = read(address, reinterpret_cast<uint8_t*>(&object), sizeof(T));
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != sizeof(T)) {
+        return -EIO;
+    }
+    return res;
+}
+
+/**
+ * Writes an object, such as a structure holding settings.
+ * @note The object is sent with as few page writes as its address allows, which write_transactions() gives at compile time.
+ * @param[in] address
+ * @param[in] object
+ * @return The size of the object in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+template <class T>
+int eeprom_i2c_core<descriptor, transport, adapter>::put(const uint32_t address, const T& object) {
+    static_assert(__is_trivially_copyable(T), "Only trivially copyable objects can be stored");
+    static_assert(sizeof(T) <= descriptor::size_total && sizeof(T) <= INT_MAX, "The object doesn't fit in the device");
+    if (address > m_size_total - sizeof(T)) {
+        return -EINVAL;
+    }
+    int res = write(address, reinterpret_cast<const uint8_t*>(&object), sizeof(T));
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != sizeof(T)) {
+        return -EIO;
+    }
+    return res;
+}
+
+/**
+ * Sets a range of bytes to the same value.
+ * @note The value is streamed from a single small buffer with page writes, so that each page costs a single write cycle whenever the i2c buffer allows it.
+ * @param[in] address
+ * @param[in] value The value of each byte.
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::fill(const uint32_t address, const uint8_t value, const size_t length) {
+    int res;
+    uint8_t pattern[m_size_write_buffer];
+
+    /* Ensure parameters are valid and caches are coherent */
+    res = write_prepare(address, length);
+    if (res < 0) {
+        return res;
+    }
+    size_t length_capped = res;
+
+    /* Write pattern */
+    memset(pattern, value, sizeof(pattern));
+    for (size_t i = 0; i < length_capped;) {
+        write_wait();
+        res = write_page(address + i, pattern, length_capped - i);
+        if (res < 0) return res;
+        if (res == 0) return i;
+        i += res;
+    }
+
+    /* Return number of bytes written */
+    return length_capped;
+}
+
+/**
+ * Sets all bytes of the device to 0xFF.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::erase(void) {
+    for (uint32_t address = 0; address < m_size_total;) {
+        size_t length = (m_size_total - address > INT_MAX) ? (INT_MAX / m_size_page) * m_size_page : m_size_total - address;
+        int res = fill(address, 0xFF, length);
+        if (res < 0) {
+            return res;
+        } else if ((size_t)res != length) {
+            return -EIO;
+        }
+        address += length;
+    }
+    return 0;
+}
+
+/**
+ * Copies a range of bytes to another place of the device.
+ * @note Overlapping ranges are handled, the destination ending up with the original content of the source.
+ * @param[in] address_source
+ * @param[in] address_destination
+ * @param[in] length
+ * @return The number of bytes copied in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::copy(const uint32_t address_source, const uint32_t address_destination, const size_t length) {
+    return copy_to(*this, address_source, address_destination, length);
+}
+
+/**
+ * Copies a range of bytes to another eeprom.
+ * @note Bytes go through a single page sized buffer. While the destination is busy with its internal write cycle, the next page is read from the source.
+ * @param[in] destination The eeprom to copy to, which can also be this device.
+ * @param[in] address_source
+ * @param[in] address_destination
+ * @param[in] length
+ * @return The number of bytes copied in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+template <class eeprom>
+int eeprom_i2c_core<descriptor, transport, adapter>::copy_to(eeprom& destination, const uint32_t address_source, const uint32_t address_destination, const size_t length) {
+    int res;
+    uint8_t bounce[eeprom::size_page()];
+    const size_t size_page_destination = eeprom::size_page();
+
+    /* Ensure addresses are valid and prevent stop addresses from creating a rollover */
+    if (address_source >= m_size_total || address_destination >= eeprom::size_total()) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address_source) ? m_size_total - address_source : length;
+    if (length_capped > eeprom::size_total() - address_destination) length_capped = eeprom::size_total() - address_destination;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Copy backwards if the destination overlaps the end of the source */
+    bool backwards = ((void*)&destination == (void*)this && address_destination > address_source && address_destination < address_source + length_capped);
+
+    /* Copy page by page, aligned on the pages of the destination */
+    for (size_t i = 0; i < length_capped;) {
+        size_t offset, length_chunk;
+        if (backwards) {
+            size_t end = length_capped - i;
+            length_chunk = ((address_destination + end - 1) % size_page_destination) + 1;
+            if (length_chunk > end) length_chunk = end;
+            offset = end - length_chunk;
+        } else {
+            offset = i;
+            length_chunk = size_page_destination - ((address_destination + offset) % size_page_destination);
+            if (length_chunk > length_capped - i) length_chunk = length_capped - i;
+        }
+        res = read(address_source + offset, bounce, length_chunk);
+        if (res < 0) return res;
+        if ((size_t)res != length_chunk) return -EIO;
+        res = destination.write(address_destination + offset, bounce, length_chunk);
+        if (res < 0) return res;
+        if ((size_t)res != length_chunk) return -EIO;
+        i += length_chunk;
+    }
+
+    /* Return number of bytes copied */
+    return length_capped;
+}
+
+#if defined(EEPROM_I2C_ASYNC)
+/**
+ * Starts writing bytes without blocking.
+ * @note The data buffer must remain valid and unchanged until the write completes.
+ * @note Call write_async_poll() regularly, from the Arduino loop function for example, to send one page at a time once the device is ready.
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length
+ * @param[in] callback An optional function called upon completion with the number of bytes written or a negative error code, or NULL.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_async(const uint32_t address, const uint8_t* const data, const size_t length, void (*callback)(int res)) {
+    int res;
+
+    /* Ensure no other write or read is in progress */
+    if (m_async_data != NULL || m_async_destination != NULL) {
+        return -EBUSY;
+    }
+
+    /* Ensure parameters are valid and caches are coherent */
+    res = write_prepare(address, length);
+    if (res < 0) {
+        return res;
+    }
+
+    /* Save state */
+    m_async_address = address;
+    m_async_data = data;
+    m_async_length = res;
+    m_async_index = 0;
+    m_async_callback = callback;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Advances the non blocking write started with write_async().
+ * @note At most one page is sent per call, and only if the device has completed its previous write cycle.
+ * @note The page is handed over to the transport, so that an interrupt or dma driven one frees the cpu while it is on the bus. Its completion is picked up by the following calls.
+ * @return -EINPROGRESS if the write is still in progress, the number of bytes written once it has completed, or another negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_async_poll(void) {
+    int res = 0;
+
+    /* Ensure a write has been started */
+    if (m_async_data == NULL) {
+        return -EINVAL;
+    }
+
+    /* Start the transfer of the next page if device is ready */
+    if (m_async_phase == ASYNC_PHASE_NONE && m_async_index < m_async_length) {
+        if (write_wait_check() == false) {
+            return -EINPROGRESS;
+        }
+
+        /* The adapter may have read or buffered these bytes since the write was started */
+        const uint32_t address = m_async_address + m_async_index;
+        const size_t length_chunk = write_transaction_length(address, m_async_length - m_async_index);
+        res = adapter_coherence((adapter*)NULL, address, length_chunk, true);
+        if (res == 0) {
+            uint8_t header[2];
+            size_t header_length = i2c_address_header(address, header);
+            m_async_i2c_address = i2c_address_for(address);
+            clock_raise();
+            stats_begin(m_async_i2c_address);
+            res = m_transport.write_start(m_async_i2c_address, header, header_length, &m_async_data[m_async_index], length_chunk, true);
+            if (res < 0) {
+                write_transaction_end(m_async_i2c_address, res);
+            } else {
+                m_async_phase = ASYNC_PHASE_WRITE;
+            }
+        }
+    }
+
+    /* Pick up its completion */
+    if (res == 0 && m_async_phase != ASYNC_PHASE_NONE) {
+        res = m_transport.complete();
+        if (res == -EINPROGRESS) {
+            return -EINPROGRESS;
+        }
+        res = async_transfer_end(res);
+        if (res > 0 && m_async_index < m_async_length) {
+            return -EINPROGRESS;
+        }
+    }
+    res = (res < 0) ? res : m_async_index;
+
+    /* Write is over */
+    void (*callback)(int res) = m_async_callback;
+    m_async_data = NULL;
+    m_async_callback = NULL;
+    if (callback != NULL) {
+        callback(res);
+    }
+    return res;
+}
+
+/**
+ * Starts reading bytes without blocking.
+ * @note The data buffer must remain valid until the read completes.
+ * @note Call read_async_poll() regularly, from the Arduino loop function for example, to transfer one chunk at a time.
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length
+ * @param[in] callback An optional function called upon completion with the number of bytes read or a negative error code, or NULL.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_async(const uint32_t address, uint8_t* const data, const size_t length, void (*callback)(int res)) {
+
+    /* Ensure no other write or read is in progress */
+    if (m_async_data != NULL || m_async_destination != NULL) {
+        return -EBUSY;
+    }
+
+    /* Ensure setup has been performed and parameters are valid */
+    if (m_transport.ready() == false || data == NULL || address >= m_size_total) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address) ? m_size_total - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Let the adapter commit the bytes it holds for writing, if they overlap with the bytes about to be read */
+    if (adapter_coherence((adapter*)NULL, address, length_capped, false) < 0) {
+        return -EIO;
+    }
+
+    /* Save state */
+    m_async_address = address;
+    m_async_destination = data;
+    m_async_length = length_capped;
+    m_async_index = 0;
+    m_async_callback = callback;
+    m_async_seek = true;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Advances the non blocking read started with read_async().
+ * @note At most one transfer is started per call, either the memory address or a chunk of data, each one being handed over to the transport so that an interrupt or dma driven one frees the cpu while it is on the bus.
+ * @note The bytes read are only valid once the read has completed.
+ * @return -EINPROGRESS if the read is still in progress, the number of bytes read once it has completed, or another negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::read_async_poll(void) {
+    int res = 0;
+
+    /* Ensure a read has been started */
+    if (m_async_destination == NULL) {
+        return -EINVAL;
+    }
+
+    /* Start the next transfer if device is ready
+     * As with read(), chunks are current address reads, the memory address only being sent at the start of each block or after another transaction */
+    if (m_async_phase == ASYNC_PHASE_NONE && m_async_index < m_async_length) {
+        if (write_wait_check() == false) {
+            return -EINPROGRESS;
+        }
+        const uint32_t address = m_async_address + m_async_index;
+        m_async_i2c_address = i2c_address_for(address);
+        clock_raise();
+        stats_begin(m_async_i2c_address);
+        if (m_async_seek == true) {
+            uint8_t header[2];
+            size_t header_length = i2c_address_header(address, header);
+            m_async_seek = false;
+            res = m_transport.write_start(m_async_i2c_address, header, header_length, NULL, 0, false);
+            m_async_phase = ASYNC_PHASE_HEADER;
+        } else {
+            size_t length_chunk = smallest(smallest(m_async_length - m_async_index, m_size_read_max), m_size_block - (address % m_size_block));
+            res = m_transport.read_start(m_async_i2c_address, &m_async_destination[m_async_index], length_chunk);
+            m_async_phase = ASYNC_PHASE_READ;
+        }
+        if (res < 0) {
+            res = async_transfer_end(res);
+        }
+    }
+
+    /* Pick up its completion, a failed chunk ending the read with the bytes read so far */
+    if (res == 0 && m_async_phase != ASYNC_PHASE_NONE) {
+        res = m_transport.complete();
+        if (res == -EINPROGRESS) {
+            return -EINPROGRESS;
+        }
+        res = async_transfer_end(res);
+        if (res >= 0 && m_async_index < m_async_length) {
+            return -EINPROGRESS;
+        }
+    }
+    res = (res < 0 && res != -ENODATA) ? res : m_async_index;
+
+    /* Read is over */
+    void (*callback)(int res) = m_async_callback;
+    m_async_destination = NULL;
+    m_async_callback = NULL;
+    if (callback != NULL) {
+        callback(res);
+    }
+    return res;
+}
+#endif
+
+/**
+ * Reads bytes from the identification page.
+ * @note With EEPROM_I2C_IDENTIFICATION_CACHE built in, the whole page is read once, then kept in ram, so that later reads cost no bus traffic. Otherwise, the bytes are read from the device every time.
+ * @param[in] address The offset of the first byte in the identification page.
+ * @param[out] data
+ * @param[in] length
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::identification_read(const uint8_t address, uint8_t* const data, const size_t length) {
+    static_assert(descriptor::size_identification > 0, "The device has no identification page");
+    int res;
+
+    /* Ensure setup has been performed and start address is valid */
+    if (m_transport.ready() == false || address >= descriptor::size_identification) {
+        return -EINVAL;
+    }
+    const size_t length_remaining = descriptor::size_identification - address;
+    size_t length_capped = (length > length_remaining) ? length_remaining : length;
+
+    /* Read the whole page into the cache, or only the bytes asked for without it */
+#if defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+    if (m_identification_cached == true) {
+        memcpy(data, &m_identification[address], length_capped);
+        return length_capped;
+    }
+    const uint8_t start = 0;
+    const size_t end = descriptor::size_identification;
+    uint8_t* const destination = m_identification;
+#else
+    const uint8_t start = address;
+    const size_t end = address + length_capped;
+    uint8_t* const destination = data;
+#endif
+    write_wait();
+    const uint8_t i2c_address = m_i2c_address_identification | (m_i2c_address & 0x07);
+    for (size_t i = start; i < end;) {
+        uint8_t header[2];
+        size_t header_length = i2c_address_header(i, header);
+        stats_begin(i2c_address);
+        res = m_transport.write(i2c_address, header, header_length, NULL, 0, false);
+        stats_end(i2c_address, (res < 0) ? -EIO : res);
+        if (res < 0) return -EIO;
+        size_t length_chunk = end - i;
+        if (length_chunk > m_size_read_max) {
+            length_chunk = m_size_read_max;
+        }
+        stats_begin(i2c_address);
+        res = m_transport.read(i2c_address, &destination[i - start], length_chunk);
+        stats_end(i2c_address, (res <= 0) ? -EIO : res);
+        if (res <= 0) return -EIO;
+        i += res;
+    }
+#if defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+    m_identification_cached = true;
+    memcpy(data, &m_identification[address], length_capped);
+#endif
+    return length_capped;
+}
+
+/**
+ * Writes bytes to the identification page.
+ * @note This fails once the identification page has been locked.
+ * @param[in] address The offset of the first byte in the identification page.
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::identification_write(const uint8_t address, const uint8_t* const data, const size_t length) {
+    static_assert(descriptor::size_identification > 0, "The device has no identification page");
+    int res;
+
+    /* Ensure setup has been performed and start address is valid */
+    if (m_transport.ready() == false || address >= descriptor::size_identification) {
+        return -EINVAL;
+    }
+    const size_t length_remaining = descriptor::size_identification - address;
+    size_t length_capped = (length > length_remaining) ? length_remaining : length;
+
+    /* Write bytes, updating the cache along the way */
+    const uint8_t i2c_address = m_i2c_address_identification | (m_i2c_address & 0x07);
+    for (size_t i = 0; i < length_capped;) {
+        write_wait();
+        size_t length_chunk = length_capped - i;
+        if (length_chunk > m_size_write_max) {
+            length_chunk = m_size_write_max;
+        }
+        res = write_transaction(i2c_address, address + i, &data[i], length_chunk);
+#if defined(EEPROM_I2C_IDENTIFICATION_CACHE)
+        if (res <= 0) {
+            m_identification_cached = false;
+        } else if (m_identification_cached) {
+            memcpy(&m_identification[address + i], &data[i], res);
+        }
+#endif
+        if (res <= 0) {
+            return (res < 0) ? res : -EIO;
+        }
+        i += res;
+    }
+
+    /* Return number of bytes written */
+    return length_capped;
+}
+
+/**
+ * Permanently locks the identification page in read only mode.
+ * @warning This can't be undone.
+ * @note Locking leaves the bytes of the page as they are, so a copy cached by identification_read() stays valid.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::identification_lock(void) {
+    static_assert(descriptor::size_identification > 0, "The device has no identification page");
+    const uint8_t lock = 0x02;
+
+    /* Ensure setup has been performed */
+    if (m_transport.ready() == false) {
+        return -EINVAL;
+    }
+
+    /* Send the lock command, which is a write to the identification page with address bit 10 set */
+    write_wait();
+    int res = write_transaction(m_i2c_address_identification | (m_i2c_address & 0x07), m_address_identification_lock, &lock, 1);
+    if (res < 0) {
+        return res;
+    }
+    return 0;
+}
+
+/**
+ * Checks whether the identification page has been locked.
+ * @note The lock command is sent without its stop condition, the data byte only being acknowledged while the page is unlocked, then aborted by a new transaction so that nothing gets locked.
+ * @note The data byte not being acknowledged is the expected answer of a locked page, so it isn't counted as a bus error in the statistics.
+ * @param[out] locked true if the identification page is locked, false otherwise.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::identification_locked(bool& locked) {
+    static_assert(descriptor::size_identification > 0, "The device has no identification page");
+    const uint8_t i2c_address = m_i2c_address_identification | (m_i2c_address & 0x07);
+    const uint8_t lock = 0x02;
+    uint8_t header[2];
+    int res;
+
+    /* Ensure setup has been performed and identification page answers */
+    if (m_transport.ready() == false) {
+        return -EINVAL;
+    }
+    write_wait();
+    stats_begin(i2c_address);
+    res = m_transport.probe(i2c_address) ? 0 : -EIO;
+    stats_end(i2c_address, res);
+    if (res < 0) {
+        return res;
+    }
+
+    /* Start a lock command and see if the data byte is acknowledged, then abort it */
+    size_t header_length = i2c_address_header(m_address_identification_lock, header);
+    stats_begin(i2c_address);
+    res = m_transport.write(i2c_address, header, header_length, &lock, 1, false);
+    stats_end(i2c_address, (res < 0) ? 0 : res);
+    locked = (res < 0);
+    stats_begin(i2c_address);
+    res = m_transport.probe(i2c_address) ? 0 : -EIO;
+    stats_end(i2c_address, res);
+    if (res < 0) {
+        return res;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Checks parameters of a write and keeps ram buffers coherent with the bytes about to be written.
+ * @param[in] address
+ * @param[in] length
+ * @return The number of bytes that can be written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_prepare(const uint32_t address, const size_t length) {
+
+    /* Ensure setup has been performed */
+    if (m_transport.ready() == false) {
+        return -EINVAL;
+    }
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= m_size_total) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address) ? m_size_total - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Let the adapter keep its own buffers coherent */
+    if (adapter_coherence((adapter*)NULL, address, length_capped, true) < 0) {
+        return -EIO;
+    }
+
+    /* Return number of bytes that can be written */
+    return length_capped;
+}
+
+/**
+ * Sends a single write transaction.
+ * @note The device must be ready, and the address and length must already have been validated.
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length The number of bytes remaining, of which only those fitting in the current page and in the i2c buffer are sent.
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_page(const uint32_t address, const uint8_t* const data, const size_t length) {
+
+    return write_transaction(i2c_address_for(address), address, data, write_transaction_length(address, length));
+}
+
+/**
+ * Sends a write transaction made of memory address bytes followed by data, and starts waiting for the write cycle it triggers.
+ * @param[in] i2c_address
+ * @param[in] address The memory address to send.
+ * @param[in] data
+ * @param[in] length The number of bytes to send, which must fit in the i2c buffer.
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_transaction(const uint8_t i2c_address, const uint32_t address, const uint8_t* const data, const size_t length) {
+
+    /* Write */
+    uint8_t header[2];
+    size_t header_length = i2c_address_header(address, header);
+    clock_raise();
+    stats_begin(i2c_address);
+    int length_written = m_transport.write(i2c_address, header, header_length, data, length, true);
+    return write_transaction_end(i2c_address, length_written);
+}
+
+/**
+ * Accounts for the end of a write transaction, and starts waiting for the write cycle it triggered.
+ * @param[in] i2c_address
+ * @param[in] length_written The number of bytes written, or a negative error code.
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::write_transaction_end(const uint8_t i2c_address, const int length_written) {
+    stats_end(i2c_address, length_written);
+    clock_restore();
+    if (length_written < 0) return length_written;
+#if defined(EEPROM_I2C_STATS)
+    m_stats.bytes_written += length_written;
+    if (length_written > 1) {
+        m_stats.writes_page++;
+    } else {
+        m_stats.writes_byte++;
+    }
+#endif
+    m_timestamp_write = micros();
+    m_timestamp_probe = m_timestamp_write;
+    m_write_pending = true;
+
+    /* Return number of bytes written */
+    return length_written;
+}
+
+#if defined(EEPROM_I2C_ASYNC)
+/**
+ * Accounts for the end of the transfer in flight of a non blocking write or read.
+ * @param[in] res The result of the transfer, as returned by the transport.
+ * @return The number of data bytes transferred, 0 for a memory address, -ENODATA for a chunk of data that couldn't be read, or another negative error code otherwise.
+ */
+template <class descriptor, class transport, class adapter>
+int eeprom_i2c_core<descriptor, transport, adapter>::async_transfer_end(const int res) {
+    enum async_phase phase = m_async_phase;
+    m_async_phase = ASYNC_PHASE_NONE;
+    if (phase == ASYNC_PHASE_WRITE) {
+        int length_written = write_transaction_end(m_async_i2c_address, res);
+        if (length_written > 0) m_async_index += length_written;
+        return length_written;
+    }
+    clock_restore();
+    if (phase == ASYNC_PHASE_HEADER) {
+        stats_end(m_async_i2c_address, (res < 0) ? -EIO : res);
+        return (res < 0) ? -EIO : 0;
+    }
+    stats_end(m_async_i2c_address, (res <= 0) ? -EIO : res);
+    if (res <= 0) return -ENODATA;
+#if defined(EEPROM_I2C_STATS)
+    m_stats.bytes_read += res;
+#endif
+    m_async_index += res;
+    if ((m_async_address + m_async_index) % m_size_block == 0) {
+        m_async_seek = true;
+    }
+    return res;
+}
+
+/**
+ * Blocks until the transfer in flight of a non blocking write or read, if any, has completed, so that another transaction can be performed.
+ * @param[in] seek true if another transaction follows, which changes the memory address held by the device, so that the read in progress sends it again.
+ */
+template <class descriptor, class transport, class adapter>
+void eeprom_i2c_core<descriptor, transport, adapter>::async_transfer_finish(const bool seek) {
+    if (m_async_phase != ASYNC_PHASE_NONE) {
+        int res;
+        while ((res = m_transport.complete()) == -EINPROGRESS) {
+        }
+        res = async_transfer_end(res);
+        if (res == -ENODATA) {
+            m_async_length = m_async_index;
+        }
+    }
+    if (seek == true) {
+        m_async_seek = true;
+    }
+}
+#endif
+
+/**
+ * Driver for i2c eeproms, with the geometry of the device given by a descriptor, and the stream interface on top of the core.
+ * @note The stream interface reads and writes at two independent indexes, through an optional read ahead buffer and a write combining buffer of up to a page.
+ * @see eeprom_i2c_parts.h for the list of supported devices.
+ */
+template <class descriptor, class transport = eeprom_i2c_wire>
+class eeprom_i2c : public eeprom_i2c_core<descriptor, transport, eeprom_i2c<descriptor, transport> >, public Stream {
+    typedef eeprom_i2c_core<descriptor, transport, eeprom_i2c<descriptor, transport> > core;
+    friend core;
+
+   public:
+    int setup(typename transport::bus& i2c_library, const uint8_t i2c_address, uint8_t* const read_buffer = NULL, const size_t read_buffer_size = 0);
+    using core::read;
+    using core::write;
+
+    /* Inherited from the stream interface */
+    int available();
+    int read();
+    int peek();
+
+    /* Inherited from the print interface */
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    void flush();
+
+    /* Seek for stream and print interfaces */
+    uint32_t seek_read(uint32_t index);
+    uint32_t seek_write(uint32_t index);
+
+   protected:
+    using core::m_transport;
+    using core::m_size_total;
+    using core::m_size_page;
+    using core::m_size_write_buffer;
+    uint32_t m_index_write = 0;
+    uint32_t m_index_read = 0;
+    uint8_t* m_read_buffer = NULL;
+    size_t m_read_buffer_size = 0;
+    uint32_t m_read_buffer_address = 0;
+    size_t m_read_buffer_length = 0;
+    uint8_t m_write_buffer[m_size_write_buffer];  // Never more than a page, nor than a single i2c transaction can carry
+    uint32_t m_write_buffer_address = 0;
+    size_t m_write_buffer_length = 0;
+    int coherence(const uint32_t address, const size_t length, const bool write);
+    int stream_fetch(uint8_t& data);
+    int write_buffer_commit(void);
+};
+
+/**
+ * Configures the driver with access over I2C.
+ * @note Call this from the Arduino setup function.
+ * @param[in] i2c_library A reference to the i2c library to use, a TwoWire with the default transport.
+ * @param[in] i2c_address The i2c address of the device.
+ * @param[in] read_buffer An optional buffer used to read ahead when reading through the stream interface, or NULL.
+ * @param[in] read_buffer_size The size of the read ahead buffer, in bytes.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::setup(typename transport::bus& i2c_library, const uint8_t i2c_address, uint8_t* const read_buffer, const size_t read_buffer_size) {
+
+    /* Ensure read ahead buffer is consistent */
+    if ((read_buffer == NULL) != (read_buffer_size == 0)) {
+        return -EINVAL;
+    }
+
+    /* Setup core */
+    int res = core::setup(i2c_library, i2c_address);
+    if (res < 0) {
+        return res;
+    }
+
+    /* Start with an empty read ahead buffer */
+    m_read_buffer = read_buffer;
+    m_read_buffer_size = read_buffer_size;
+    m_read_buffer_length = 0;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Keeps the stream buffers coherent with the bytes about to be read or written by the core.
+ * @param[in] address
+ * @param[in] length
+ * @param[in] write true if the bytes are about to be written, or false if they are about to be read.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::coherence(const uint32_t address, const size_t length, const bool write) {
+
+    /* Commit pending print output first if it overlaps with the bytes, to preserve ordering */
+    if (address < m_write_buffer_address + m_write_buffer_length && m_write_buffer_address < address + length) {
+        if (write_buffer_commit() < 0) return -EIO;
+    }
+
+    /* Invalidate read ahead buffer if it overlaps with the bytes about to be written */
+    if (write && address < m_read_buffer_address + m_read_buffer_length && m_read_buffer_address < address + length) {
+        m_read_buffer_length = 0;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Gets the number of bytes available in the stream. This is only for bytes that have already arrived.
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streamavailable/
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::available() {
+    if (m_index_read <= m_size_total) {
+        return (m_size_total - m_index_read > INT_MAX) ? INT_MAX : m_size_total - m_index_read;
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * Reads characters from an incoming stream to the buffer.
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streamread
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::read() {
+    uint8_t data;
+    int res = stream_fetch(data);
+    if (res < 0) {
+        return 0;
+    } else {
+        m_index_read += res;
+        return data;
+    }
+}
+
+/**
+ * Read a byte from the file without advancing to the next one. That is, successive calls to peek() will return the same value, as will the next call to read().
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streampeek/
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::peek() {
+    uint8_t data;
+    int res = stream_fetch(data);
+    if (res < 0) {
+        return 0;
+    } else {
+        return data;
+    }
+}
+
+/**
+ * Retrieves the byte at the stream read index, from the print write buffer or the read ahead buffer when possible.
+ * @note Bytes written through the print interface and not committed yet are newer than the ones in the eeprom, and than the ones in the read ahead buffer.
+ * @note When the read index is outside of the read ahead buffer, the buffer is refilled with a single sequential read.
+ * @param[out] data The byte read.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::stream_fetch(uint8_t& data) {
+    int res;
+
+    /* Serve byte from the print write buffer if it is pending there */
+    if (m_index_read >= m_write_buffer_address && m_index_read < m_write_buffer_address + m_write_buffer_length) {
+        data = m_write_buffer[m_index_read - m_write_buffer_address];
+        return 1;
+    }
+
+    /* Without read ahead buffer, perform a single byte read */
+    if (m_read_buffer == NULL) {
+        return read(m_index_read, &data, 1);
+    }
+
+    /* Refill read ahead buffer if read index has left its window */
+    if (m_index_read < m_read_buffer_address || m_index_read >= m_read_buffer_address + m_read_buffer_length) {
+        m_read_buffer_length = 0;
+        res = read(m_index_read, m_read_buffer, m_read_buffer_size);
+        if (res <= 0) {
+            return (res < 0) ? res : -EIO;
+        }
+        m_read_buffer_address = m_index_read;
+        m_read_buffer_length = res;
+    }
+
+    /* Serve byte from ram */
+    data = m_read_buffer[m_index_read - m_read_buffer_address];
+    return 1;
+}
+
+/**
+ *
+ * @param[in] data
+ * @note Inherited from the print interface
+ */
+template <class descriptor, class transport>
+size_t eeprom_i2c<descriptor, transport>::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+/**
+ * Writes bytes at the print write index.
+ * @note Bytes are collected in a buffer and committed as a single page write when the buffer fills up, when a page boundary is crossed, when the write index is moved elsewhere, or when flush() is called.
+ * @param[in] data
+ * @param[in] length
+ * @note Inherited from the print interface
+ */
+template <class descriptor, class transport>
+size_t eeprom_i2c<descriptor, transport>::write(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+
+        /* Commit pending bytes if the new ones can't be appended to them */
+        if (m_write_buffer_length > 0 && (m_index_write != m_write_buffer_address + m_write_buffer_length || m_index_write % m_size_page == 0 || m_write_buffer_length == m_size_write_buffer)) {
+            if (write_buffer_commit() < 0) return i;
+        }
+
+        /* Ensure setup has been performed and write index is valid */
+        if (m_transport.ready() == false || m_index_write >= m_size_total) {
+            return i;
+        }
+
+        /* Append as many bytes as possible without crossing a page boundary nor overflowing the buffer */
+        if (m_write_buffer_length == 0) {
+            m_write_buffer_address = m_index_write;
+        }
+        size_t length_chunk = m_size_page - (m_index_write % m_size_page);
+        if (length_chunk > length - i) {
+            length_chunk = length - i;
+        }
+        if (length_chunk > m_size_write_buffer - m_write_buffer_length) {
+            length_chunk = m_size_write_buffer - m_write_buffer_length;
+        }
+        memcpy(&m_write_buffer[m_write_buffer_length], &data[i], length_chunk);
+        m_write_buffer_length += length_chunk;
+        m_index_write += length_chunk;
+        i += length_chunk;
+
+        /* Commit as soon as the page or the buffer is complete */
+        if (m_index_write % m_size_page == 0 || m_write_buffer_length == m_size_write_buffer) {
+            if (write_buffer_commit() < 0) return i;
+        }
+    }
+    return i;
+}
+
+/**
+ * Commits pending bytes written through the print interface.
+ * @note Inherited from the print interface
+ */
+template <class descriptor, class transport>
+void eeprom_i2c<descriptor, transport>::flush() {
+    write_buffer_commit();
+}
+
+/**
+ * Sends the bytes collected in the print write buffer as a single page write.
+ * @note On failure, the bytes are kept so that the commit can be attempted again.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, class transport>
+int eeprom_i2c<descriptor, transport>::write_buffer_commit(void) {
+
+    /* Nothing to do if buffer is empty */
+    if (m_write_buffer_length == 0) {
+        return 0;
+    }
+
+    /* Mark buffer as empty before writing so the overlap check in write() doesn't recurse */
+    size_t length = m_write_buffer_length;
+    m_write_buffer_length = 0;
+    int res = write(m_write_buffer_address, m_write_buffer, length);
+    if (res < 0 || (size_t)res != length) {
+        m_write_buffer_length = length;
+        return (res < 0) ? res : -EIO;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * @brief
+ * @param index
+ * @return
+ */
+template <class descriptor, class transport>
+uint32_t eeprom_i2c<descriptor, transport>::seek_read(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_read = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+/**
+ * @brief
+ * @param index
+ * @return
+ */
+template <class descriptor, class transport>
+uint32_t eeprom_i2c<descriptor, transport>::seek_write(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_write = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+#endif
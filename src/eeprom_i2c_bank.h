@@ -0,0 +1,379 @@
+#ifndef EEPROM_I2C_BANK_H
+#define EEPROM_I2C_BANK_H
+
+/* Generic driver */
+#include "eeprom_i2c.h"
+
+/* Writes are spread over the devices with their non blocking writes */
+#if !defined(EEPROM_I2C_ASYNC)
+#error "eeprom_i2c_bank needs EEPROM_I2C_ASYNC when EEPROM_I2C_SLIM is defined"
+#endif
+
+/**
+ * Aggregates several identical i2c eeproms sharing the same bus into a single linear address space.
+ * @note By default the devices are concatenated, the first device holding the lowest addresses.
+ * @note In interleaved mode, consecutive pages are spread over consecutive devices, so that sequential writes keep all of them busy at the same time.
+ * @note Writes are split per device and sent concurrently: while a device is in its internal write cycle, the next page is sent to another one.
+ * @tparam descriptor The descriptor of the devices, from eeprom_i2c_parts.h.
+ * @tparam count The number of devices.
+ * @tparam transport The transport to the bus shared by the devices, such as eeprom_i2c_sim to simulate the bank.
+ */
+template <class descriptor, uint8_t count, class transport = eeprom_i2c_wire>
+class eeprom_i2c_bank : public Stream {
+    static_assert(count >= 1 && count <= (8 >> descriptor::address_block_bits), "Too many devices for the i2c address range");
+
+   public:
+    int setup(typename transport::bus& i2c_library, const uint8_t* const i2c_addresses, const bool interleaved = false);
+    bool detect(void);
+    int read(const uint32_t address, uint8_t* const data, const size_t length);
+    int write(const uint32_t address, const uint8_t* const data, const size_t length);
+    eeprom_i2c<descriptor, transport>& device(const uint8_t index);
+
+    /* Inherited from the stream interface */
+    int available();
+    int read();
+    int peek();
+
+    /* Inherited from the print interface */
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    void flush();
+
+    /* Seek for stream and print interfaces */
+    uint32_t seek_read(uint32_t index);
+    uint32_t seek_write(uint32_t index);
+
+    /* Geometry of the bank */
+    static constexpr uint32_t size_total(void) {
+        return descriptor::size_total * count;
+    }
+    static constexpr uint16_t size_page(void) {
+        return descriptor::size_page;
+    }
+
+   protected:
+    eeprom_i2c<descriptor, transport> m_devices[count];
+    bool m_interleaved = false;
+    uint32_t m_index_write = 0;
+    uint32_t m_index_read = 0;
+    static constexpr uint32_t m_size_total = descriptor::size_total * count;
+    static constexpr uint32_t m_size_device = descriptor::size_total;
+    static constexpr uint16_t m_size_page = descriptor::size_page;
+    uint8_t map(const uint32_t address, uint32_t& address_device, size_t& length_contiguous);
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class descriptor, uint8_t count, class transport>
+constexpr uint32_t eeprom_i2c_bank<descriptor, count, transport>::m_size_total;
+template <class descriptor, uint8_t count, class transport>
+constexpr uint32_t eeprom_i2c_bank<descriptor, count, transport>::m_size_device;
+template <class descriptor, uint8_t count, class transport>
+constexpr uint16_t eeprom_i2c_bank<descriptor, count, transport>::m_size_page;
+
+/**
+ * Configures the bank with access over I2C.
+ * @note Call this from the Arduino setup function.
+ * @note Make sure the I2C library has been initialized with a call to its begin function for example.
+ * @param[in] i2c_library A reference to the i2c library to use, a TwoWire with the default transport.
+ * @param[in] i2c_addresses An array with the i2c address of each device, in the order they appear in the address space.
+ * @param[in] interleaved true to spread consecutive pages over consecutive devices, false to concatenate devices.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::setup(typename transport::bus& i2c_library, const uint8_t* const i2c_addresses, const bool interleaved) {
+    int res;
+
+    /* Ensure addresses are given */
+    if (i2c_addresses == NULL) {
+        return -EINVAL;
+    }
+
+    /* Setup each device */
+    for (uint8_t i = 0; i < count; i++) {
+        res = m_devices[i].setup(i2c_library, i2c_addresses[i]);
+        if (res < 0) {
+            return res;
+        }
+    }
+    m_interleaved = interleaved;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Tries to detect all the devices.
+ * @return true if every device has been detected, or false otherwise.
+ */
+template <class descriptor, uint8_t count, class transport>
+bool eeprom_i2c_bank<descriptor, count, transport>::detect(void) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (m_devices[i].detect() == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Gives access to one of the devices of the bank, to configure it for example.
+ * @param[in] index The index of the device, in the order given during setup.
+ * @return A reference to the device.
+ */
+template <class descriptor, uint8_t count, class transport>
+eeprom_i2c<descriptor, transport>& eeprom_i2c_bank<descriptor, count, transport>::device(const uint8_t index) {
+    return m_devices[(index < count) ? index : 0];
+}
+
+/**
+ * Finds which device holds the given address.
+ * @param[in] address The address in the bank.
+ * @param[out] address_device The address in the device.
+ * @param[out] length_contiguous The number of bytes from this address that are contiguous in the device.
+ * @return The index of the device.
+ */
+template <class descriptor, uint8_t count, class transport>
+uint8_t eeprom_i2c_bank<descriptor, count, transport>::map(const uint32_t address, uint32_t& address_device, size_t& length_contiguous) {
+    if (m_interleaved) {
+        uint32_t page = address / m_size_page;
+        address_device = (page / count) * m_size_page + (address % m_size_page);
+        length_contiguous = m_size_page - (address % m_size_page);
+        return page % count;
+    } else {
+        address_device = address % m_size_device;
+        length_contiguous = m_size_device - address_device;
+        return address / m_size_device;
+    }
+}
+
+/**
+ *
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::read(const uint32_t address, uint8_t* const data, const size_t length) {
+    int res;
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= m_size_total) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address) ? m_size_total - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Read each contiguous piece from its device */
+    for (size_t i = 0; i < length_capped;) {
+        uint32_t address_device;
+        size_t length_chunk;
+        uint8_t index = map(address + i, address_device, length_chunk);
+        if (length_chunk > length_capped - i) {
+            length_chunk = length_capped - i;
+        }
+        res = m_devices[index].read(address_device, &data[i], length_chunk);
+        if (res < 0) return res;
+        if (res == 0) return i;
+        i += res;
+    }
+
+    /* Return number of bytes read */
+    return length_capped;
+}
+
+/**
+ *
+ * @note Pieces going to different devices are written concurrently, each device being given its next piece as soon as it is ready.
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::write(const uint32_t address, const uint8_t* const data, const size_t length) {
+    int res;
+
+    /* Ensure start address is valid and prevent stop address from creating a rollover */
+    if (address >= m_size_total) {
+        return -EINVAL;
+    }
+    size_t length_capped = (length > m_size_total - address) ? m_size_total - address : length;
+    if (length_capped > INT_MAX) length_capped = INT_MAX;
+
+    /* Submit pieces in order, and make the devices progress while the next one is busy */
+    bool busy[count] = {false};
+    int error = 0;
+    size_t i = 0;
+    for (;;) {
+
+        /* Submit next piece if its device is free */
+        if (i < length_capped && error == 0) {
+            uint32_t address_device;
+            size_t length_chunk;
+            uint8_t index = map(address + i, address_device, length_chunk);
+            if (length_chunk > length_capped - i) {
+                length_chunk = length_capped - i;
+            }
+            if (busy[index] == false) {
+                res = m_devices[index].write_async(address_device, &data[i], length_chunk);
+                if (res < 0) {
+                    error = res;
+                } else {
+                    busy[index] = true;
+                    i += length_chunk;
+                }
+                continue;
+            }
+        }
+
+        /* Make all devices progress, and stop once they are all done */
+        bool idle = true;
+        for (uint8_t j = 0; j < count; j++) {
+            if (busy[j] == true) {
+                res = m_devices[j].write_async_poll();
+                if (res == -EINPROGRESS) {
+                    idle = false;
+                } else {
+                    busy[j] = false;
+                    if (res < 0 && error == 0) error = res;
+                }
+            }
+        }
+        if (idle == true && (i >= length_capped || error != 0)) {
+            break;
+        }
+    }
+
+    /* Return number of bytes written */
+    if (error < 0) {
+        return error;
+    }
+    return length_capped;
+}
+
+/**
+ * Gets the number of bytes available in the stream. This is only for bytes that have already arrived.
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streamavailable/
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::available() {
+    if (m_index_read <= m_size_total) {
+        return (m_size_total - m_index_read > INT_MAX) ? INT_MAX : m_size_total - m_index_read;
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * Reads characters from an incoming stream to the buffer.
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streamread
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::read() {
+    int data = peek();
+    if (m_index_read < m_size_total) {
+        m_index_read++;
+    }
+    return data;
+}
+
+/**
+ * Read a byte from the file without advancing to the next one. That is, successive calls to peek() will return the same value, as will the next call to read().
+ * @note Inherited from the stream interface
+ * @see https://www.arduino.cc/reference/en/language/functions/communication/stream/streampeek/
+ */
+template <class descriptor, uint8_t count, class transport>
+int eeprom_i2c_bank<descriptor, count, transport>::peek() {
+    if (m_index_read >= m_size_total) {
+        return 0;
+    }
+    uint32_t address_device;
+    size_t length_contiguous;
+    uint8_t index = map(m_index_read, address_device, length_contiguous);
+    m_devices[index].seek_read(address_device);
+    return m_devices[index].peek();
+}
+
+/**
+ *
+ * @param[in] data
+ * @note Inherited from the print interface
+ */
+template <class descriptor, uint8_t count, class transport>
+size_t eeprom_i2c_bank<descriptor, count, transport>::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+/**
+ * Writes bytes at the print write index.
+ * @note Bytes are handed over to the print interface of each device, which collects them until flush() is called.
+ * @param[in] data
+ * @param[in] length
+ * @note Inherited from the print interface
+ */
+template <class descriptor, uint8_t count, class transport>
+size_t eeprom_i2c_bank<descriptor, count, transport>::write(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length && m_index_write < m_size_total) {
+        uint32_t address_device;
+        size_t length_chunk;
+        uint8_t index = map(m_index_write, address_device, length_chunk);
+        if (length_chunk > length - i) {
+            length_chunk = length - i;
+        }
+        m_devices[index].seek_write(address_device);
+        size_t length_written = m_devices[index].write(&data[i], length_chunk);
+        m_index_write += length_written;
+        i += length_written;
+        if (length_written != length_chunk) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Commits pending bytes written through the print interface, on all devices.
+ * @note Inherited from the print interface
+ */
+template <class descriptor, uint8_t count, class transport>
+void eeprom_i2c_bank<descriptor, count, transport>::flush() {
+    for (uint8_t i = 0; i < count; i++) {
+        m_devices[i].flush();
+    }
+}
+
+/**
+ * @brief
+ * @param index
+ * @return
+ */
+template <class descriptor, uint8_t count, class transport>
+uint32_t eeprom_i2c_bank<descriptor, count, transport>::seek_read(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_read = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+/**
+ * @brief
+ * @param index
+ * @return
+ */
+template <class descriptor, uint8_t count, class transport>
+uint32_t eeprom_i2c_bank<descriptor, count, transport>::seek_write(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_write = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef EEPROM_I2C_PARTS_H
+#define EEPROM_I2C_PARTS_H
+
+/* C/C++ libraries */
+#include <stdint.h>
+
+/**
+ * Descriptors of i2c eeproms, to be used as the template parameter of the eeprom_i2c class.
+ * @note size_total: capacity in bytes, a power of two.
+ * @note size_page: page write buffer in bytes, a power of two.
+ * @note address_width: number of memory address bytes sent after the device address (1 or 2).
+ * @note address_block_bits: number of memory address bits carried by the lowest bits of the device address.
+ * @note duration_write_cycle: maximum internal write cycle time in microseconds.
+ * @note frequency_max: highest i2c clock frequency in Hz, at the lowest supply voltage allowing it.
+ * @note size_identification: size in bytes of the lockable identification page, or 0 if the device has none.
+ */
+struct eeprom_i2c_24c02 {
+    static constexpr uint32_t size_total = 256;  // 2 Kbit
+    static constexpr uint16_t size_page = 8;
+    static constexpr uint8_t address_width = 1;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c04 {
+    static constexpr uint32_t size_total = 512;  // 4 Kbit
+    static constexpr uint16_t size_page = 16;
+    static constexpr uint8_t address_width = 1;
+    static constexpr uint8_t address_block_bits = 1;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c08 {
+    static constexpr uint32_t size_total = 1024;  // 8 Kbit
+    static constexpr uint16_t size_page = 16;
+    static constexpr uint8_t address_width = 1;
+    static constexpr uint8_t address_block_bits = 2;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c16 {
+    static constexpr uint32_t size_total = 2048;  // 16 Kbit
+    static constexpr uint16_t size_page = 16;
+    static constexpr uint8_t address_width = 1;
+    static constexpr uint8_t address_block_bits = 3;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c32 {
+    static constexpr uint32_t size_total = 4096;  // 32 Kbit
+    static constexpr uint16_t size_page = 32;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c64 {
+    static constexpr uint32_t size_total = 8192;  // 64 Kbit
+    static constexpr uint16_t size_page = 32;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c128 {
+    static constexpr uint32_t size_total = 16384;  // 128 Kbit
+    static constexpr uint16_t size_page = 64;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c256 {
+    static constexpr uint32_t size_total = 32768;  // 256 Kbit
+    static constexpr uint16_t size_page = 64;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_24c512 {
+    static constexpr uint32_t size_total = 65536;  // 512 Kbit
+    static constexpr uint16_t size_page = 128;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 400000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_m24m01 {
+    static constexpr uint32_t size_total = 131072;  // 1 Mbit
+    static constexpr uint16_t size_page = 256;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 1;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 1000000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+struct eeprom_i2c_m24m02 {
+    static constexpr uint32_t size_total = 262144;  // 2 Mbit
+    static constexpr uint16_t size_page = 256;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 2;
+    static constexpr uint32_t duration_write_cycle = 10000;
+    static constexpr uint32_t frequency_max = 1000000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+/* The STMicroelectronics M24C64 has the generic 24C64 geometry, and supports Fast-mode Plus */
+struct eeprom_i2c_m24c64 {
+    static constexpr uint32_t size_total = 8192;  // 64 Kbit
+    static constexpr uint16_t size_page = 32;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 1000000;
+    static constexpr uint16_t size_identification = 0;
+};
+
+/* The STMicroelectronics M24C64-D adds an identification page to the M24C64 */
+struct eeprom_i2c_m24c64_d {
+    static constexpr uint32_t size_total = 8192;  // 64 Kbit
+    static constexpr uint16_t size_page = 32;
+    static constexpr uint8_t address_width = 2;
+    static constexpr uint8_t address_block_bits = 0;
+    static constexpr uint32_t duration_write_cycle = 5000;
+    static constexpr uint32_t frequency_max = 1000000;
+    static constexpr uint16_t size_identification = 32;
+};
+
+#endif
@@ -0,0 +1,413 @@
+#ifndef EEPROM_I2C_SIM_H
+#define EEPROM_I2C_SIM_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Counters of the bus activity seen by a simulated eeprom.
+ */
+struct eeprom_i2c_sim_counters {
+    uint32_t transactions;  // Transactions addressed to the device, acknowledged or not
+    uint32_t nacks;         // Transactions refused because the device was in its write cycle
+    uint32_t write_cycles;  // Internal write cycles started
+    uint32_t bytes;         // Bytes on the bus, device address bytes included
+    uint64_t duration_bus;  // Time the bus has been busy, in nanoseconds, at the clock frequencies in use
+};
+
+/**
+ * Simulated i2c eeprom held in ram, with the geometry of the device given by a descriptor.
+ * @note It behaves like the real device as seen from the bus: memory address bytes, page rollover during writes, memory rollover during reads, and no acknowledge during the internal write cycle.
+ * @note Devices with an identification page also answer at its own device address, including the lock command.
+ * @note Bus time is counted from the number of bits of each transaction and the clock frequency, so that strategies can be compared without hardware.
+ * @note The write cycle is timed with micros(), so that all the write completion strategies of the driver see the same behaviour as with the real device.
+ * @note Several devices can share the same simulated bus by chaining them, with transactions addressed to another device handed over to the next one.
+ * @tparam descriptor The descriptor of the simulated device, from eeprom_i2c_parts.h.
+ */
+template <class descriptor>
+class eeprom_i2c_sim_device {
+
+   public:
+    /**
+     * Configures the simulated device.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[in] duration_write_cycle The duration of the internal write cycle in microseconds, which is shorter than the maximum in the descriptor for most real devices.
+     * @return 0 in case of success, or a negative error code otherwise.
+     */
+    int setup(const uint8_t i2c_address, const uint32_t duration_write_cycle = descriptor::duration_write_cycle) {
+        if ((i2c_address & 0xF8) != 0x50 || (i2c_address & m_mask_block) != 0) {
+            return -EINVAL;
+        }
+        m_i2c_address = i2c_address;
+        m_duration_write_cycle = duration_write_cycle;
+        memset(m_memory, 0xFF, sizeof(m_memory));
+        memset(m_identification, 0xFF, sizeof(m_identification));
+        m_identification_locked = false;
+        m_pointer = 0;
+        m_write_pending = false;
+        counters_reset();
+        return 0;
+    }
+
+    /**
+     * Puts another device on the same simulated bus, such as the other devices of an eeprom_i2c_bank.
+     * @param[in] next The next device, which can itself be chained to another one, or NULL.
+     */
+    void chain(eeprom_i2c_sim_device* const next) {
+        m_next = next;
+    }
+
+    /**
+     * Gives access to the content of the simulated memory, to fill it or check it.
+     * @return A pointer to the memory, of descriptor::size_total bytes.
+     */
+    uint8_t* memory(void) {
+        return m_memory;
+    }
+
+    /**
+     * Gets the counters of the bus activity.
+     * @return A reference to the counters.
+     */
+    const struct eeprom_i2c_sim_counters& counters(void) {
+        return m_counters;
+    }
+
+    /**
+     * Sets all counters back to zero.
+     */
+    void counters_reset(void) {
+        memset(&m_counters, 0, sizeof(m_counters));
+    }
+
+    /**
+     * Changes the clock frequency of the simulated bus, for this device and the ones chained to it.
+     * @param[in] frequency The clock frequency, in Hz.
+     */
+    void clock(const uint32_t frequency) {
+        m_clock = frequency;
+        if (m_next != NULL) {
+            m_next->clock(frequency);
+        }
+    }
+
+    /**
+     * Simulates a write transaction.
+     * @note Data bytes are only stored once the stop condition is received, which also starts the internal write cycle.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @param[in] header The first bytes sent, holding the memory address.
+     * @param[in] header_length The number of header bytes.
+     * @param[in] data The bytes sent after the header.
+     * @param[in] length The number of data bytes.
+     * @param[in] stop true if the transaction ends with a stop condition.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    bool write(const uint8_t i2c_address, const uint8_t* const header, const size_t header_length, const uint8_t* const data, const size_t length, const bool stop) {
+        if (addressed(i2c_address) == false) {
+            return (m_next != NULL) ? m_next->write(i2c_address, header, header_length, data, length, stop) : false;
+        }
+        bool identification;
+        if (transaction_begin(i2c_address, identification) == false) {
+            return false;
+        }
+        transaction_end(header_length + length);
+        uint32_t address = (uint32_t)(i2c_address & m_mask_block) << (8 * descriptor::address_width);
+        for (size_t i = 0; i < header_length; i++) {
+            address |= (uint32_t)header[i] << (8 * (header_length - 1 - i));
+        }
+        if (identification) {
+            return write_identification(address, data, length, stop);
+        }
+        if (header_length == descriptor::address_width) {
+            m_pointer = address % descriptor::size_total;
+        }
+        if (length > 0 && stop) {
+            uint32_t page = m_pointer - (m_pointer % descriptor::size_page);
+            for (size_t i = 0; i < length; i++) {
+                m_memory[m_pointer] = data[i];
+                m_pointer = page + ((m_pointer + 1) % descriptor::size_page);
+            }
+            m_timestamp_write = micros();
+            m_write_pending = true;
+            m_counters.write_cycles++;
+        }
+        return true;
+    }
+
+    /**
+     * Simulates a read transaction from the current address.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @param[out] data A buffer to store the bytes read.
+     * @param[in] length The number of bytes to read.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    bool read(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        if (addressed(i2c_address) == false) {
+            return (m_next != NULL) ? m_next->read(i2c_address, data, length) : false;
+        }
+        bool identification;
+        if (transaction_begin(i2c_address, identification) == false) {
+            return false;
+        }
+        transaction_end(length);
+        if (identification) {
+            for (size_t i = 0; i < length; i++) {
+                data[i] = m_identification[m_identification_pointer];
+                m_identification_pointer = (m_identification_pointer + 1) % sizeof(m_identification);
+            }
+            return true;
+        }
+        for (size_t i = 0; i < length; i++) {
+            data[i] = m_memory[m_pointer];
+            m_pointer = (m_pointer + 1) % descriptor::size_total;
+        }
+        return true;
+    }
+
+   protected:
+    uint8_t m_memory[descriptor::size_total];
+    uint8_t m_identification[(descriptor::size_identification > 0) ? descriptor::size_identification : 1];
+    uint32_t m_identification_pointer = 0;
+    bool m_identification_locked = false;
+    uint8_t m_i2c_address = 0;
+    uint32_t m_pointer = 0;
+    uint32_t m_duration_write_cycle = descriptor::duration_write_cycle;
+    uint32_t m_timestamp_write = 0;
+    bool m_write_pending = false;
+    uint32_t m_clock = 100000;
+    struct eeprom_i2c_sim_counters m_counters = {};
+    eeprom_i2c_sim_device* m_next = NULL;
+    static constexpr uint8_t m_mask_block = (1 << descriptor::address_block_bits) - 1;
+
+    /**
+     * Checks whether a transaction is addressed to the memory or to the identification page of this device.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @return true if the device is addressed, or false otherwise.
+     */
+    bool addressed(const uint8_t i2c_address) {
+        bool identification = (descriptor::size_identification > 0 && i2c_address == (0x58 | (m_i2c_address & 0x07)));
+        return (i2c_address & ~m_mask_block) == m_i2c_address || identification;
+    }
+
+    /**
+     * Accounts for the start condition and the device address byte, and checks whether the device acknowledges it.
+     * @param[in] i2c_address The i2c address of the transaction.
+     * @param[out] identification true if the transaction is addressed to the identification page.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    bool transaction_begin(const uint8_t i2c_address, bool& identification) {
+        identification = (descriptor::size_identification > 0 && i2c_address == (0x58 | (m_i2c_address & 0x07)));
+        m_counters.transactions++;
+        if (m_write_pending && micros() - m_timestamp_write < m_duration_write_cycle) {
+            m_counters.nacks++;
+            transaction_end(0);
+            return false;
+        }
+        m_write_pending = false;
+        return true;
+    }
+
+    /**
+     * Simulates the part of a write transaction addressed to the identification page, once the memory address has been received.
+     * @note Data bytes aren't acknowledged once the page has been locked.
+     * @param[in] address The memory address, whose bit 10 selects the lock command.
+     * @param[in] data
+     * @param[in] length
+     * @param[in] stop
+     * @return true if the device acknowledged all bytes, or false otherwise.
+     */
+    bool write_identification(const uint32_t address, const uint8_t* const data, const size_t length, const bool stop) {
+        m_identification_pointer = address % sizeof(m_identification);
+        if (length == 0) {
+            return true;
+        } else if (m_identification_locked) {
+            return false;
+        } else if (stop == false) {
+            return true;
+        }
+        if (address & 0x0400) {
+            m_identification_locked = (data[0] & 0x02) != 0;
+        } else {
+            for (size_t i = 0; i < length; i++) {
+                m_identification[m_identification_pointer] = data[i];
+                m_identification_pointer = (m_identification_pointer + 1) % sizeof(m_identification);
+            }
+        }
+        m_timestamp_write = micros();
+        m_write_pending = true;
+        m_counters.write_cycles++;
+        return true;
+    }
+
+    /**
+     * Accounts for the bus time of a transaction: start condition, device address byte, other bytes, and stop condition.
+     * @param[in] length The number of bytes following the device address byte.
+     */
+    void transaction_end(const size_t length) {
+        uint32_t bits = 1 + 9 * (1 + length) + 1;
+        m_counters.bytes += 1 + length;
+        m_counters.duration_bus += (uint64_t)bits * 1000000000UL / m_clock;
+    }
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class descriptor>
+constexpr uint8_t eeprom_i2c_sim_device<descriptor>::m_mask_block;
+
+/**
+ * Transport of the eeprom_i2c driver to a simulated eeprom.
+ * @note Use it as the second template parameter of eeprom_i2c, then give the simulated device to eeprom_i2c::setup.
+ * @note Transfers started without blocking only complete once the bus time of their bytes has elapsed, as measured with micros(), like with an interrupt or dma driven transport.
+ * @tparam descriptor The descriptor of the simulated device.
+ * @tparam buffer_size The size of the i2c buffer to emulate, address bytes included for writes.
+ */
+template <class descriptor, size_t buffer_size = 32>
+class eeprom_i2c_sim {
+    static_assert(buffer_size >= 3, "I2C buffer must be able to hold at least 2 address bytes and 1 data byte");
+
+   public:
+    typedef eeprom_i2c_sim_device<descriptor> bus;
+    static constexpr size_t size_write_max(void) {
+        return buffer_size;
+    }
+    static constexpr size_t size_read_max(void) {
+        return buffer_size;
+    }
+
+    /**
+     * Configures the transport.
+     * @param[in] device A reference to the simulated device.
+     * @return 0 in case of success, or a negative error code otherwise.
+     */
+    int setup(bus& device) {
+        m_device = &device;
+        return 0;
+    }
+
+    /**
+     * Checks whether the transport has been configured.
+     * @return true if the transport is ready to be used, or false otherwise.
+     */
+    bool ready(void) {
+        return m_device != NULL;
+    }
+
+    /**
+     * Changes the clock frequency of the simulated bus.
+     * @param[in] frequency The clock frequency, in Hz.
+     * @return 0 in case of success, or a negative error code otherwise.
+     */
+    int clock(const uint32_t frequency) {
+        if (frequency == 0) {
+            return -EINVAL;
+        }
+        m_device->clock(frequency);
+        m_clock = frequency;
+        return 0;
+    }
+
+    /**
+     * Checks whether the device acknowledges its address.
+     * @param[in] i2c_address The i2c address of the device.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    bool probe(const uint8_t i2c_address) {
+        return m_device->write(i2c_address, NULL, 0, NULL, 0, true);
+    }
+
+    /**
+     * Performs a write transaction made of a header followed by data, truncated to the size of the emulated buffer.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[in] header The first bytes to send, such as a memory address.
+     * @param[in] header_length The number of header bytes.
+     * @param[in] data The bytes to send after the header, or NULL.
+     * @param[in] length The number of data bytes.
+     * @param[in] stop true to end the transaction with a stop condition, false to end it with nothing so a repeated start can follow.
+     * @return The number of data bytes sent in case of success, or a negative error code otherwise.
+     */
+    int write(const uint8_t i2c_address, const uint8_t* const header, const size_t header_length, const uint8_t* const data, const size_t length, const bool stop) {
+        size_t length_sent = (length > buffer_size - header_length) ? buffer_size - header_length : length;
+        if (m_device->write(i2c_address, header, header_length, data, length_sent, stop) == false) return -EIO;
+        return length_sent;
+    }
+
+    /**
+     * Performs a read transaction, truncated to the size of the emulated buffer.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[out] data A buffer to store the bytes read.
+     * @param[in] length The number of bytes to read.
+     * @return The number of bytes read in case of success, or a negative error code otherwise.
+     */
+    int read(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        size_t length_read = (length > buffer_size) ? buffer_size : length;
+        if (m_device->read(i2c_address, data, length_read) == false) {
+            return -EIO;
+        }
+        return length_read;
+    }
+
+    /**
+     * Starts a write transaction without blocking.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[in] header The first bytes to send, such as a memory address.
+     * @param[in] header_length The number of header bytes.
+     * @param[in] data The bytes to send after the header, or NULL.
+     * @param[in] length The number of data bytes.
+     * @param[in] stop true to end the transaction with a stop condition, false to end it with nothing so a repeated start can follow.
+     * @return 0 if the transfer has been started, or a negative error code otherwise.
+     */
+    int write_start(const uint8_t i2c_address, const uint8_t* const header, const size_t header_length, const uint8_t* const data, const size_t length, const bool stop) {
+        m_result = write(i2c_address, header, header_length, data, length, stop);
+        transfer_start(header_length + ((m_result > 0) ? m_result : 0));
+        return 0;
+    }
+
+    /**
+     * Starts a read transaction without blocking.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[out] data A buffer to store the bytes read.
+     * @param[in] length The number of bytes to read.
+     * @return 0 if the transfer has been started, or a negative error code otherwise.
+     */
+    int read_start(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        m_result = read(i2c_address, data, length);
+        transfer_start((m_result > 0) ? m_result : 0);
+        return 0;
+    }
+
+    /**
+     * Checks whether the transfer started last has completed.
+     * @return -EINPROGRESS while the transfer is on the bus, then what write() or read() would have returned for it.
+     */
+    int complete(void) {
+        if (micros() - m_transfer_start < m_transfer_duration) {
+            return -EINPROGRESS;
+        }
+        return m_result;
+    }
+
+   protected:
+    bus* m_device = NULL;
+    uint32_t m_clock = 100000;
+    int m_result = 0;                  // Result of the transfer started last
+    uint32_t m_transfer_start = 0;     // When it was started, in microseconds
+    uint32_t m_transfer_duration = 0;  // Its bus time, in microseconds
+
+    /**
+     * Starts timing a transfer from its bus time: start condition, device address byte, other bytes, and stop condition.
+     * @param[in] length The number of bytes following the device address byte.
+     */
+    void transfer_start(const size_t length) {
+        uint32_t bits = 1 + 9 * (1 + length) + 1;
+        m_transfer_start = micros();
+        m_transfer_duration = ((uint64_t)bits * 1000000UL + m_clock - 1) / m_clock;
+    }
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef EEPROM_I2C_WIRE_H
+#define EEPROM_I2C_WIRE_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Wire.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Determine length of i2c transactions supported by the platform
+ * This can be overridden by defining I2C_BUFFER_SIZE as a build flag */
+#if !defined(I2C_BUFFER_SIZE)
+#if defined(WIRE_BUFFER_SIZE)
+#define I2C_BUFFER_SIZE WIRE_BUFFER_SIZE  // RP2040, megaAVR, ...
+#elif defined(I2C_BUFFER_LENGTH)
+#define I2C_BUFFER_SIZE I2C_BUFFER_LENGTH  // ESP32
+#elif defined(BUFFER_LENGTH)
+#define I2C_BUFFER_SIZE BUFFER_LENGTH  // AVR, ESP8266, STM32, Teensy, ...
+#else
+#define I2C_BUFFER_SIZE 32  // Conservative default for unknown platforms
+#endif
+#endif
+#if I2C_BUFFER_SIZE < 3
+#error "I2C buffer must be able to hold at least 2 address bytes and 1 data byte"
+#endif
+
+/**
+ * Transport of the eeprom_i2c driver over the Arduino TwoWire library.
+ * @note A transport is the only part of the driver that talks to the bus, so other backends (interrupt or dma driven, simulated, ...) can be swapped in through the second template parameter of eeprom_i2c.
+ * @note A transport must provide:
+ * - a bus type, used by eeprom_i2c::setup,
+ * - the largest write transaction (address bytes included) and read transaction it can carry,
+ * - a probe of a device address, a write transaction with an optional stop condition, and a read transaction,
+ * - the same write and read transactions started without blocking, with a poll of their completion, for eeprom_i2c::write_async and eeprom_i2c::read_async, unless EEPROM_I2C_ASYNC is left out of the build,
+ * - a way to change the clock frequency of the bus.
+ * @note An interrupt or dma driven transport returns from write_start() and read_start() as soon as the transfer is queued, so that the cpu is free while the bytes are on the bus. This one performs them at once with the Wire library, which blocks, and only keeps their result for complete().
+ * @note At most one transfer is started at a time, and complete() is polled until it reports its end before any other call is made.
+ */
+class eeprom_i2c_wire {
+
+   public:
+    typedef TwoWire bus;
+    static constexpr size_t size_write_max(void) {
+        return I2C_BUFFER_SIZE;
+    }
+    static constexpr size_t size_read_max(void) {
+        return I2C_BUFFER_SIZE;
+    }
+
+    /**
+     * Configures the transport.
+     * @param[in] i2c_library A reference to the i2c library to use.
+     * @return 0 in case of success, or a negative error code otherwise.
+     */
+    int setup(TwoWire& i2c_library) {
+        m_i2c_library = &i2c_library;
+        return 0;
+    }
+
+    /**
+     * Checks whether the transport has been configured.
+     * @return true if the transport is ready to be used, or false otherwise.
+     */
+    bool ready(void) {
+        return m_i2c_library != NULL;
+    }
+
+    /**
+     * Changes the clock frequency of the bus.
+     * @param[in] frequency The clock frequency, in Hz.
+     * @return 0 in case of success, or a negative error code otherwise.
+     */
+    int clock(const uint32_t frequency) {
+        m_i2c_library->setClock(frequency);
+        return 0;
+    }
+
+    /**
+     * Checks whether a device acknowledges its address.
+     * @param[in] i2c_address The i2c address of the device.
+     * @return true if the device acknowledged, or false otherwise.
+     */
+    bool probe(const uint8_t i2c_address) {
+        m_i2c_library->beginTransmission(i2c_address);
+        return m_i2c_library->endTransmission() == 0;
+    }
+
+    /**
+     * Performs a write transaction made of a header followed by data.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[in] header The first bytes to send, such as a memory address.
+     * @param[in] header_length The number of header bytes.
+     * @param[in] data The bytes to send after the header, or NULL.
+     * @param[in] length The number of data bytes, so that the whole transaction is at most size_write_max() bytes.
+     * @param[in] stop true to end the transaction with a stop condition, false to end it with nothing so a repeated start can follow.
+     * @return The number of data bytes sent in case of success, or a negative error code otherwise.
+     */
+    int write(const uint8_t i2c_address, const uint8_t* const header, const size_t header_length, const uint8_t* const data, const size_t length, const bool stop) {
+        m_i2c_library->beginTransmission(i2c_address);
+        m_i2c_library->write(header, header_length);
+        size_t length_written = (length > 0) ? m_i2c_library->write(data, length) : 0;
+        if (m_i2c_library->endTransmission(stop) != 0) return -EIO;
+        return length_written;
+    }
+
+    /**
+     * Performs a read transaction, ended with a stop condition.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[out] data A buffer to store the bytes read.
+     * @param[in] length The number of bytes to read, at most size_read_max().
+     * @return The number of bytes read in case of success, or a negative error code otherwise.
+     */
+    int read(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        int res = m_i2c_library->requestFrom(i2c_address, length);
+        if (res <= 0) {
+            return -EIO;
+        }
+        for (size_t i = 0; i < (size_t)res; i++) {
+            data[i] = m_i2c_library->read();
+        }
+        return res;
+    }
+
+#if defined(EEPROM_I2C_ASYNC)
+    /**
+     * Starts a write transaction without blocking.
+     * @note The header is copied before returning, but the data must remain valid until the transfer completes.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[in] header The first bytes to send, such as a memory address.
+     * @param[in] header_length The number of header bytes.
+     * @param[in] data The bytes to send after the header, or NULL.
+     * @param[in] length The number of data bytes, so that the whole transaction is at most size_write_max() bytes.
+     * @param[in] stop true to end the transaction with a stop condition, false to end it with nothing so a repeated start can follow.
+     * @return 0 if the transfer has been started, or a negative error code otherwise.
+     */
+    int write_start(const uint8_t i2c_address, const uint8_t* const header, const size_t header_length, const uint8_t* const data, const size_t length, const bool stop) {
+        m_result = write(i2c_address, header, header_length, data, length, stop);
+        return 0;
+    }
+
+    /**
+     * Starts a read transaction without blocking, ended with a stop condition.
+     * @param[in] i2c_address The i2c address of the device.
+     * @param[out] data A buffer to store the bytes read, only valid once the transfer has completed.
+     * @param[in] length The number of bytes to read, at most size_read_max().
+     * @return 0 if the transfer has been started, or a negative error code otherwise.
+     */
+    int read_start(const uint8_t i2c_address, uint8_t* const data, const size_t length) {
+        m_result = read(i2c_address, data, length);
+        return 0;
+    }
+
+    /**
+     * Checks whether the transfer started last has completed.
+     * @return -EINPROGRESS while the transfer is on the bus, then what write() or read() would have returned for it.
+     */
+    int complete(void) {
+        return m_result;
+    }
+#endif
+
+   protected:
+    TwoWire* m_i2c_library = NULL;
+#if defined(EEPROM_I2C_ASYNC)
+    int m_result = 0;  // Result of the transfer started last
+#endif
+};
+
+#endif
@@ -0,0 +1,394 @@
+#ifndef EEPROM_KV_H
+#define EEPROM_KV_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Project code */
+#include "eeprom_crc.h"
+
+/**
+ * Power fail safe key value store, stored in a range of pages of an eeprom.
+ * @note Each key owns a pair of page aligned slots, and each slot holds a header (key, generation, length, crc) followed by the value.
+ * @note A new value is always written to the slot that doesn't hold the current one, so an interrupted write never corrupts the previous value.
+ * @note During setup, all slots are checked once to build a ram index of the keys, after which getting a value costs a single sequential read.
+ * @tparam eeprom The type of the underlying storage, such as eeprom_i2c or eeprom_i2c_bank.
+ * @tparam capacity The maximum number of keys, which sets the size of the ram index (8 bytes per key).
+ */
+template <class eeprom, uint16_t capacity>
+class eeprom_kv {
+
+   public:
+    int setup(eeprom& storage, const uint32_t address, const uint32_t length, const size_t size_value);
+    int get(const uint16_t key, uint8_t* const data, const size_t length);
+    int set(const uint16_t key, const uint8_t* const data, const size_t length);
+    int remove(const uint16_t key);
+    uint16_t count(void);
+
+   protected:
+    struct entry {
+        uint16_t key;
+        uint16_t pair;  // Index of the pair of slots, with the upper bit set when the current value is in the second slot
+        uint16_t generation;
+        uint16_t length;
+    };
+    eeprom* m_storage = NULL;
+    uint32_t m_address = 0;
+    uint32_t m_size_slot = 0;
+    size_t m_size_value = 0;
+    uint16_t m_pairs = 0;
+    uint16_t m_count = 0;
+    struct entry m_index[capacity];
+    uint8_t m_pairs_used[(capacity + 7) / 8];
+    static constexpr uint16_t m_key_empty = 0xFFFF;
+    static constexpr uint16_t m_pair_second = 0x8000;
+    static constexpr size_t m_size_page = eeprom::size_page();
+    static constexpr size_t m_size_header = 8;  // Key (2 bytes), generation (2 bytes), length (2 bytes), crc (2 bytes)
+    struct entry* index_find(const uint16_t key, const bool insert);
+    uint32_t slot_address(const uint16_t pair, const bool second);
+    int slot_check(const uint32_t address, uint16_t& key, uint16_t& generation, uint16_t& length);
+    static_assert(capacity > 0 && capacity < m_pair_second, "Capacity must fit in the index");
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom, uint16_t capacity>
+constexpr uint16_t eeprom_kv<eeprom, capacity>::m_key_empty;
+template <class eeprom, uint16_t capacity>
+constexpr uint16_t eeprom_kv<eeprom, capacity>::m_pair_second;
+template <class eeprom, uint16_t capacity>
+constexpr size_t eeprom_kv<eeprom, capacity>::m_size_page;
+template <class eeprom, uint16_t capacity>
+constexpr size_t eeprom_kv<eeprom, capacity>::m_size_header;
+
+/**
+ * Configures the store and builds the ram index of the keys.
+ * @note Call this from the Arduino setup function, after the eeprom has been setup.
+ * @note The range and the maximum value size must stay the same across reboots for previously stored values to be found.
+ * @param[in] storage A reference to the eeprom to use.
+ * @param[in] address The start of the range used by the store, aligned on a page.
+ * @param[in] length The length of the range used by the store, in bytes.
+ * @param[in] size_value The maximum size of a value, in bytes.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, uint16_t capacity>
+int eeprom_kv<eeprom, capacity>::setup(eeprom& storage, const uint32_t address, const uint32_t length, const size_t size_value) {
+    int res;
+
+    /* Ensure parameters are valid */
+    if (address % m_size_page != 0 || address + length > eeprom::size_total() || address + length < address || size_value == 0 || size_value > 0xFFFF) {
+        return -EINVAL;
+    }
+    m_storage = &storage;
+    m_address = address;
+    m_size_value = size_value;
+    m_size_slot = ((m_size_header + size_value + m_size_page - 1) / m_size_page) * m_size_page;
+    m_pairs = ((length / (2 * m_size_slot)) > capacity) ? capacity : (length / (2 * m_size_slot));
+    if (m_pairs == 0) {
+        return -EINVAL;
+    }
+
+    /* Start with an empty index */
+    for (uint16_t i = 0; i < capacity; i++) {
+        m_index[i].key = m_key_empty;
+    }
+    memset(m_pairs_used, 0, sizeof(m_pairs_used));
+    m_count = 0;
+
+    /* Check both slots of each pair, and index the newest valid one */
+    for (uint16_t pair = 0; pair < m_pairs; pair++) {
+        uint16_t key[2], generation[2], length_value[2];
+        bool valid[2];
+        for (uint8_t j = 0; j < 2; j++) {
+            res = slot_check(slot_address(pair, j), key[j], generation[j], length_value[j]);
+            if (res == -EIO) return res;
+            valid[j] = (res == 0);
+        }
+        if (valid[0] && valid[1] && key[0] != key[1]) {
+            valid[(int16_t)(generation[0] - generation[1]) > 0 ? 1 : 0] = false;
+        }
+        bool second;
+        if (valid[0] && valid[1]) {
+            second = ((int16_t)(generation[1] - generation[0]) > 0);
+        } else if (valid[0] || valid[1]) {
+            second = valid[1];
+        } else {
+            continue;
+        }
+        struct entry* e = index_find(key[second], true);
+        if (e == NULL || e->key != m_key_empty) {
+            continue;
+        }
+        e->key = key[second];
+        e->pair = pair | (second ? m_pair_second : 0);
+        e->generation = generation[second];
+        e->length = length_value[second];
+        m_pairs_used[pair / 8] |= (1 << (pair % 8));
+        m_count++;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Gets the value associated with a key.
+ * @param[in] key The key, any value but 0xFFFF.
+ * @param[out] data A buffer to store the value.
+ * @param[in] length The size of the buffer, value bytes beyond it are dropped.
+ * @return The number of bytes stored in the buffer in case of success, -ENOENT if the key doesn't exist, or another negative error code otherwise.
+ */
+template <class eeprom, uint16_t capacity>
+int eeprom_kv<eeprom, capacity>::get(const uint16_t key, uint8_t* const data, const size_t length) {
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL || key == m_key_empty) {
+        return -EINVAL;
+    }
+
+    /* Lookup key in the index */
+    struct entry* e = index_find(key, false);
+    if (e == NULL) {
+        return -ENOENT;
+    }
+
+    /* Read value, which has already been checked during setup */
+    size_t length_read = (e->length > length) ? length : e->length;
+    return m_storage->read(slot_address(e->pair & ~m_pair_second, e->pair & m_pair_second) + m_size_header, data, length_read);
+}
+
+/**
+ * Associates a value to a key.
+ * @note Nothing is written if the value is the same as the current one, and otherwise only the pages of the spare slot that differ are written.
+ * @param[in] key The key, any value but 0xFFFF.
+ * @param[in] data The value.
+ * @param[in] length The length of the value, at most the size given during setup.
+ * @return The length of the value in case of success, -ENOSPC if there is no room for a new key, or another negative error code otherwise.
+ */
+template <class eeprom, uint16_t capacity>
+int eeprom_kv<eeprom, capacity>::set(const uint16_t key, const uint8_t* const data, const size_t length) {
+    int res;
+    uint8_t page[m_size_page];
+    uint8_t header[m_size_header];
+
+    /* Ensure setup has been performed and value fits */
+    if (m_storage == NULL || key == m_key_empty || length > m_size_value || (data == NULL && length > 0)) {
+        return -EINVAL;
+    }
+
+    /* Lookup key in the index, or find a free pair of slots for it */
+    struct entry* e = index_find(key, true);
+    if (e == NULL) {
+        return -ENOSPC;
+    }
+    uint16_t pair;
+    bool second;
+    uint16_t generation;
+    if (e->key == key) {
+
+        /* Skip write if the value is unchanged */
+        pair = e->pair & ~m_pair_second;
+        if (e->length == length) {
+            uint32_t address_value = slot_address(pair, e->pair & m_pair_second) + m_size_header;
+            size_t i;
+            for (i = 0; i < length; i += m_size_page) {
+                size_t length_chunk = (length - i > m_size_page) ? m_size_page : length - i;
+                res = m_storage->read(address_value + i, page, length_chunk);
+                if (res < 0) return res;
+                if (memcmp(page, &data[i], length_chunk) != 0) break;
+            }
+            if (i >= length) {
+                return length;
+            }
+        }
+        second = !(e->pair & m_pair_second);
+        generation = e->generation + 1;
+    } else {
+        for (pair = 0; pair < m_pairs; pair++) {
+            if ((m_pairs_used[pair / 8] & (1 << (pair % 8))) == 0) break;
+        }
+        if (pair >= m_pairs) {
+            return -ENOSPC;
+        }
+        second = false;
+        generation = 0;
+    }
+
+    /* Build header */
+    header[0] = (uint8_t)(key >> 0);
+    header[1] = (uint8_t)(key >> 8);
+    header[2] = (uint8_t)(generation >> 0);
+    header[3] = (uint8_t)(generation >> 8);
+    header[4] = (uint8_t)(length >> 0);
+    header[5] = (uint8_t)(length >> 8);
+    uint16_t crc = eeprom_crc16(eeprom_crc16(0xFFFF, header, 6), data, length);
+    header[6] = (uint8_t)(crc >> 0);
+    header[7] = (uint8_t)(crc >> 8);
+
+    /* Write header and value in the spare slot, page by page, skipping pages already holding the right bytes */
+    uint32_t address_slot = slot_address(pair, second);
+    size_t length_entry = m_size_header + length;
+    for (size_t i = 0; i < length_entry; i += m_size_page) {
+        size_t length_chunk = (length_entry - i > m_size_page) ? m_size_page : length_entry - i;
+        uint8_t current[m_size_page];
+        for (size_t j = 0; j < length_chunk; j++) {
+            page[j] = (i + j < m_size_header) ? header[i + j] : data[i + j - m_size_header];
+        }
+        res = m_storage->read(address_slot + i, current, length_chunk);
+        if (res < 0) return res;
+        if (memcmp(current, page, length_chunk) == 0) continue;
+        res = m_storage->write(address_slot + i, page, length_chunk);
+        if (res < 0) return res;
+        if ((size_t)res != length_chunk) return -EIO;
+    }
+
+    /* Update index */
+    if (e->key != key) {
+        e->key = key;
+        m_pairs_used[pair / 8] |= (1 << (pair % 8));
+        m_count++;
+    }
+    e->pair = pair | (second ? m_pair_second : 0);
+    e->generation = generation;
+    e->length = length;
+
+    /* Return length of value */
+    return length;
+}
+
+/**
+ * Removes a key and its value.
+ * @note The slot holding the previous value is invalidated first, so an interrupted removal never brings back an older value.
+ * @param[in] key The key, any value but 0xFFFF.
+ * @return 0 in case of success, -ENOENT if the key doesn't exist, or another negative error code otherwise.
+ */
+template <class eeprom, uint16_t capacity>
+int eeprom_kv<eeprom, capacity>::remove(const uint16_t key) {
+    int res;
+    const uint8_t empty[2] = {0xFF, 0xFF};
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL || key == m_key_empty) {
+        return -EINVAL;
+    }
+
+    /* Lookup key in the index */
+    struct entry* e = index_find(key, false);
+    if (e == NULL) {
+        return -ENOENT;
+    }
+
+    /* Invalidate spare slot, then current slot */
+    uint16_t pair = e->pair & ~m_pair_second;
+    bool second = e->pair & m_pair_second;
+    res = m_storage->write(slot_address(pair, !second), empty, sizeof(empty));
+    if (res < 0) return res;
+    res = m_storage->write(slot_address(pair, second), empty, sizeof(empty));
+    if (res < 0) return res;
+
+    /* Remove from index, and reinsert following entries of the same probe sequence */
+    m_pairs_used[pair / 8] &= ~(1 << (pair % 8));
+    m_count--;
+    uint16_t i = e - m_index;
+    m_index[i].key = m_key_empty;
+    for (uint16_t j = (i + 1) % capacity; m_index[j].key != m_key_empty; j = (j + 1) % capacity) {
+        struct entry moved = m_index[j];
+        m_index[j].key = m_key_empty;
+        *index_find(moved.key, true) = moved;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Gets the number of keys in the store.
+ * @return The number of keys.
+ */
+template <class eeprom, uint16_t capacity>
+uint16_t eeprom_kv<eeprom, capacity>::count(void) {
+    return m_count;
+}
+
+/**
+ * Looks up a key in the ram index, which is an open addressing hash table with linear probing.
+ * @param[in] key The key.
+ * @param[in] insert true to get the free entry where the key would go if it isn't in the index.
+ * @return A pointer to the entry of the key, or to a free entry, or NULL.
+ */
+template <class eeprom, uint16_t capacity>
+typename eeprom_kv<eeprom, capacity>::entry* eeprom_kv<eeprom, capacity>::index_find(const uint16_t key, const bool insert) {
+    uint16_t i = (uint16_t)(key * 40503U) % capacity;
+    for (uint16_t n = 0; n < capacity; n++, i = (i + 1) % capacity) {
+        if (m_index[i].key == key) {
+            return &m_index[i];
+        } else if (m_index[i].key == m_key_empty) {
+            return insert ? &m_index[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Computes the address of a slot.
+ * @param[in] pair The index of the pair of slots.
+ * @param[in] second true for the second slot of the pair, false for the first one.
+ * @return The address of the slot.
+ */
+template <class eeprom, uint16_t capacity>
+uint32_t eeprom_kv<eeprom, capacity>::slot_address(const uint16_t pair, const bool second) {
+    return m_address + ((uint32_t)pair * 2 + (second ? 1 : 0)) * m_size_slot;
+}
+
+/**
+ * Reads and checks the entry stored in a slot.
+ * @param[in] address The address of the slot.
+ * @param[out] key The key of the entry.
+ * @param[out] generation The generation of the entry.
+ * @param[out] length The length of the value of the entry.
+ * @return 0 in case of success, -ENOENT if the slot doesn't hold a valid entry, or -EIO in case of communication failure.
+ */
+template <class eeprom, uint16_t capacity>
+int eeprom_kv<eeprom, capacity>::slot_check(const uint32_t address, uint16_t& key, uint16_t& generation, uint16_t& length) {
+    int res;
+    uint8_t page[m_size_page];
+
+    /* Read first page, which holds the header */
+    size_t length_chunk = (m_size_slot > m_size_page) ? m_size_page : m_size_slot;
+    res = m_storage->read(address, page, length_chunk);
+    if (res < 0 || (size_t)res != length_chunk) return -EIO;
+    key = ((uint16_t)page[0] << 0) | ((uint16_t)page[1] << 8);
+    generation = ((uint16_t)page[2] << 0) | ((uint16_t)page[3] << 8);
+    length = ((uint16_t)page[4] << 0) | ((uint16_t)page[5] << 8);
+    uint16_t crc_stored = ((uint16_t)page[6] << 0) | ((uint16_t)page[7] << 8);
+    if (key == m_key_empty || length > m_size_value) {
+        return -ENOENT;
+    }
+
+    /* Compute crc over header and value */
+    size_t length_entry = m_size_header + length;
+    uint16_t crc = eeprom_crc16(0xFFFF, page, 6);
+    for (size_t i = 0; i < length_entry;) {
+        size_t start = (i == 0) ? m_size_header : 0;
+        size_t end = (length_entry - i > m_size_page) ? m_size_page : length_entry - i;
+        crc = eeprom_crc16(crc, &page[start], end - start);
+        i += end;
+        if (i < length_entry) {
+            length_chunk = (length_entry - i > m_size_page) ? m_size_page : length_entry - i;
+            res = m_storage->read(address + i, page, length_chunk);
+            if (res < 0 || (size_t)res != length_chunk) return -EIO;
+        }
+    }
+    if (crc != crc_stored) {
+        return -ENOENT;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef EEPROM_LOG_H
+#define EEPROM_LOG_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Project code */
+#include "eeprom_crc.h"
+
+/**
+ * Wear leveled append only log, stored in a range of pages of an eeprom.
+ * @note Each record occupies one page, and is made of a sequence number, a length, a crc and the payload.
+ * @note Records are written in a circular way over the whole range, so that every page gets the same amount of wear.
+ * @note Once the range is full, appending a record overwrites the oldest one.
+ * @note During setup, the newest record is found with a binary search over the sequence numbers, which takes a number of page reads logarithmic in the number of pages.
+ * @tparam eeprom The type of the underlying storage, such as eeprom_i2c or eeprom_i2c_bank.
+ */
+template <class eeprom>
+class eeprom_log {
+
+   public:
+    int setup(eeprom& storage, const uint32_t address = 0, const uint32_t length = eeprom::size_total());
+    int append(const uint8_t* const data, const size_t length);
+    int read(const uint32_t index, uint8_t* const data, const size_t length);
+    int read_latest(uint8_t* const data, const size_t length);
+    uint32_t count(void);
+    uint32_t sequence(void);
+
+    /* Largest payload of a record */
+    static constexpr size_t size_record(void) {
+        return eeprom::size_page() - m_size_header;
+    }
+
+   protected:
+    eeprom* m_storage = NULL;
+    uint32_t m_address = 0;
+    uint32_t m_slots = 0;
+    uint32_t m_head = 0;
+    uint32_t m_tail = 0;
+    uint32_t m_count = 0;
+    uint32_t m_sequence = 0;
+    static constexpr size_t m_size_page = eeprom::size_page();
+    static constexpr size_t m_size_header = 6;  // Sequence number (4 bytes), length (1 byte), crc (1 byte)
+    int slot_read(const uint32_t slot, uint8_t* const page, uint32_t& sequence);
+    static_assert(eeprom::size_page() > m_size_header && eeprom::size_page() - m_size_header <= 255, "Pages must be able to hold a header and a payload whose length fits in a byte");
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom>
+constexpr size_t eeprom_log<eeprom>::m_size_page;
+template <class eeprom>
+constexpr size_t eeprom_log<eeprom>::m_size_header;
+
+/**
+ * Configures the log and finds its newest record.
+ * @note Call this from the Arduino setup function, after the eeprom has been setup.
+ * @param[in] storage A reference to the eeprom to use.
+ * @param[in] address The start of the range used by the log, aligned on a page.
+ * @param[in] length The length of the range used by the log, a multiple of the page size and at least two pages.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_log<eeprom>::setup(eeprom& storage, const uint32_t address, const uint32_t length) {
+    int res;
+    uint8_t page[m_size_page];
+    uint32_t sequence_first, sequence;
+
+    /* Ensure range is valid */
+    if (address % m_size_page != 0 || length % m_size_page != 0 || length < 2 * m_size_page || address + length > eeprom::size_total() || address + length < address) {
+        return -EINVAL;
+    }
+    m_storage = &storage;
+    m_address = address;
+    m_slots = length / m_size_page;
+
+    /* Find newest record */
+    res = slot_read(0, page, sequence_first);
+    if (res == -EIO) {
+        return res;
+    } else if (res < 0) {
+
+        /* First slot is empty: either nothing has been written yet, or the last write to it has been interrupted after the log wrapped around */
+        res = slot_read(m_slots - 1, page, sequence);
+        if (res == -EIO) {
+            return res;
+        } else if (res < 0) {
+            m_head = m_slots - 1;
+            m_sequence = (uint32_t)-1;
+            m_tail = 0;
+            m_count = 0;
+            return 0;
+        }
+        m_head = m_slots - 1;
+        m_sequence = sequence;
+    } else {
+
+        /* Slots from the first one up to the newest record hold consecutive sequence numbers, so binary search the last of them */
+        uint32_t low = 0, high = m_slots;
+        m_sequence = sequence_first;
+        while (high - low > 1) {
+            uint32_t middle = low + (high - low) / 2;
+            res = slot_read(middle, page, sequence);
+            if (res == -EIO) {
+                return res;
+            } else if (res >= 0 && sequence - sequence_first < m_slots) {
+                low = middle;
+                m_sequence = sequence;
+            } else {
+                high = middle;
+            }
+        }
+        m_head = low;
+    }
+
+    /* Find oldest record, which follows the newest one if the log has wrapped around, maybe with an interrupted write in between */
+    for (uint32_t skip = 1; skip <= 2; skip++) {
+        res = slot_read((m_head + skip) % m_slots, page, sequence);
+        if (res == -EIO) {
+            return res;
+        } else if (res >= 0 && sequence == m_sequence - m_slots + skip) {
+            m_tail = (m_head + skip) % m_slots;
+            m_count = m_slots + 1 - skip;
+            return 0;
+        }
+    }
+    res = slot_read(0, page, sequence);
+    if (res == -EIO) {
+        return res;
+    }
+    m_tail = (res >= 0) ? 0 : 1;
+    m_count = m_head + 1 - m_tail;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Appends a record to the log.
+ * @note If the log is full, the oldest record is overwritten.
+ * @param[in] data The payload of the record.
+ * @param[in] length The length of the payload, at most size_record().
+ * @return The length of the payload in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_log<eeprom>::append(const uint8_t* const data, const size_t length) {
+    int res;
+    uint8_t page[m_size_page];
+
+    /* Ensure setup has been performed and payload fits */
+    if (m_storage == NULL || length > size_record() || (data == NULL && length > 0)) {
+        return -EINVAL;
+    }
+
+    /* Build record */
+    uint32_t slot = (m_head + 1) % m_slots;
+    uint32_t sequence = m_sequence + 1;
+    page[0] = (uint8_t)(sequence >> 0);
+    page[1] = (uint8_t)(sequence >> 8);
+    page[2] = (uint8_t)(sequence >> 16);
+    page[3] = (uint8_t)(sequence >> 24);
+    page[4] = (uint8_t)length;
+    memcpy(&page[m_size_header], data, length);
+    page[5] = eeprom_crc8(eeprom_crc8(0xFF, page, 5), &page[m_size_header], length);
+
+    /* Write it in the slot following the newest record */
+    res = m_storage->write(m_address + slot * m_size_page, page, m_size_header + length);
+    if (res < 0) {
+        return res;
+    } else if ((size_t)res != m_size_header + length) {
+        return -EIO;
+    }
+
+    /* Update state */
+    if (m_count == m_slots) {
+        m_tail = (m_tail + 1) % m_slots;
+    } else {
+        m_count++;
+    }
+    m_head = slot;
+    m_sequence = sequence;
+
+    /* Return length of payload */
+    return length;
+}
+
+/**
+ * Reads a record from the log.
+ * @param[in] index The index of the record, 0 being the oldest and count() - 1 the newest.
+ * @param[out] data A buffer to store the payload of the record.
+ * @param[in] length The size of the buffer, payload bytes beyond it are dropped.
+ * @return The number of payload bytes stored in the buffer in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_log<eeprom>::read(const uint32_t index, uint8_t* const data, const size_t length) {
+    int res;
+    uint8_t page[m_size_page];
+    uint32_t sequence;
+
+    /* Ensure setup has been performed and record exists */
+    if (m_storage == NULL || index >= m_count) {
+        return -EINVAL;
+    }
+
+    /* Read record */
+    res = slot_read((m_tail + index) % m_slots, page, sequence);
+    if (res < 0) {
+        return res;
+    }
+    size_t length_copied = ((size_t)res > length) ? length : res;
+    memcpy(data, &page[m_size_header], length_copied);
+
+    /* Return number of bytes read */
+    return length_copied;
+}
+
+/**
+ * Reads the newest record of the log.
+ * @param[out] data A buffer to store the payload of the record.
+ * @param[in] length The size of the buffer, payload bytes beyond it are dropped.
+ * @return The number of payload bytes stored in the buffer in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_log<eeprom>::read_latest(uint8_t* const data, const size_t length) {
+    if (m_count == 0) {
+        return -ENOENT;
+    }
+    return read(m_count - 1, data, length);
+}
+
+/**
+ * Gets the number of records in the log.
+ * @return The number of records.
+ */
+template <class eeprom>
+uint32_t eeprom_log<eeprom>::count(void) {
+    return m_count;
+}
+
+/**
+ * Gets the sequence number of the newest record, which keeps increasing across wrap arounds and reboots.
+ * @return The sequence number.
+ */
+template <class eeprom>
+uint32_t eeprom_log<eeprom>::sequence(void) {
+    return m_sequence;
+}
+
+/**
+ * Reads and checks the record stored in a slot.
+ * @param[in] slot The index of the slot.
+ * @param[out] page A page sized buffer to hold the record.
+ * @param[out] sequence The sequence number of the record.
+ * @return The length of the payload in case of success, -ENOENT if the slot doesn't hold a valid record, or -EIO in case of communication failure.
+ */
+template <class eeprom>
+int eeprom_log<eeprom>::slot_read(const uint32_t slot, uint8_t* const page, uint32_t& sequence) {
+    int res;
+
+    /* Read slot */
+    res = m_storage->read(m_address + slot * m_size_page, page, m_size_page);
+    if (res < 0 || (size_t)res != m_size_page) {
+        return -EIO;
+    }
+
+    /* Check record */
+    size_t length = page[4];
+    if (length > size_record()) {
+        return -ENOENT;
+    }
+    if (page[5] != eeprom_crc8(eeprom_crc8(0xFF, page, 5), &page[m_size_header], length)) {
+        return -ENOENT;
+    }
+    sequence = ((uint32_t)page[0] << 0) | ((uint32_t)page[1] << 8) | ((uint32_t)page[2] << 16) | ((uint32_t)page[3] << 24);
+
+    /* Return length of payload */
+    return length;
+}
+
+#endif
@@ -0,0 +1,519 @@
+#ifndef EEPROM_RTOS_H
+#define EEPROM_RTOS_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+#include <Stream.h>
+
+/* FreeRTOS, whose headers live in different places depending on the core */
+#if defined(ARDUINO_ARCH_ESP32) || defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#elif defined(ARDUINO_ARCH_AVR)
+#include <Arduino_FreeRTOS.h>
+#include <event_groups.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+#else
+#include <FreeRTOS.h>
+#include <event_groups.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+#endif
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Type of the stack depth given to xTaskCreate, which kernels older than 10.0 don't name */
+#if !defined(configSTACK_DEPTH_TYPE)
+#define configSTACK_DEPTH_TYPE uint16_t
+#endif
+
+/* Default stack size of the worker task, in the unit used by xTaskCreate on the platform: bytes on ESP32 and AVR, words elsewhere */
+#if !defined(EEPROM_RTOS_WORKER_STACK)
+#if defined(ARDUINO_ARCH_ESP32) || defined(ESP_PLATFORM)
+#define EEPROM_RTOS_WORKER_STACK 2048
+#elif defined(ARDUINO_ARCH_AVR)
+#define EEPROM_RTOS_WORKER_STACK 192
+#else
+#define EEPROM_RTOS_WORKER_STACK 256
+#endif
+#endif
+
+/**
+ * Thread safe access to an eeprom from several FreeRTOS tasks.
+ * @note Every access to the bus is done with a mutex held, which can be shared with the other devices of the same bus.
+ * @note Writes are queued and performed by a worker task, the writing task being blocked on a notification until its write completes, instead of spinning during write cycles.
+ * @note The worker sleeps through the write cycle of each page it sends, and reading tasks are blocked until it is over, so that no task ever polls the device.
+ * @note Between pages, reads from other tasks are served while a long write is in progress, unless they overlap it.
+ * @tparam eeprom The type of the underlying storage, which must provide write_async() and write_async_poll(), such as eeprom_i2c, with EEPROM_I2C_ASYNC built in when EEPROM_I2C_SLIM is defined.
+ */
+template <class eeprom>
+class eeprom_rtos {
+
+   public:
+    int setup(eeprom& storage, SemaphoreHandle_t mutex = NULL, const UBaseType_t worker_priority = 1, const configSTACK_DEPTH_TYPE worker_stack = EEPROM_RTOS_WORKER_STACK);
+    int read(const uint32_t address, uint8_t* const data, const size_t length);
+    int write(const uint32_t address, const uint8_t* const data, const size_t length);
+    SemaphoreHandle_t mutex(void);
+
+    /* Geometry of the underlying storage */
+    static constexpr uint32_t size_total(void) {
+        return eeprom::size_total();
+    }
+    static constexpr uint16_t size_page(void) {
+        return eeprom::size_page();
+    }
+
+   protected:
+    struct request {
+        uint32_t address;
+        const uint8_t* data;
+        size_t length;
+        TaskHandle_t task;
+        int* result;
+    };
+    eeprom* m_storage = NULL;
+    SemaphoreHandle_t m_mutex = NULL;
+    QueueHandle_t m_queue = NULL;
+    EventGroupHandle_t m_events = NULL;
+    uint32_t m_active_address = 0;  // Range of the write in progress, empty if none
+    size_t m_active_length = 0;
+    static constexpr EventBits_t m_event_ready = 0x01;  // Set when the device isn't in a write cycle
+    static constexpr EventBits_t m_event_idle = 0x02;   // Set when no write is in progress
+    static void worker(void* parameter);
+    void worker_sleep(void);
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom>
+constexpr EventBits_t eeprom_rtos<eeprom>::m_event_ready;
+template <class eeprom>
+constexpr EventBits_t eeprom_rtos<eeprom>::m_event_idle;
+
+/**
+ * Configures the thread safe access, and starts the worker task.
+ * @note Call this once, before any other task accesses the eeprom.
+ * @param[in] storage A reference to the eeprom to use, which must have been setup.
+ * @param[in] mutex An optional mutex already guarding the bus, to share it with other devices, or NULL to create one.
+ * @param[in] worker_priority The priority of the worker task.
+ * @param[in] worker_stack The stack size of the worker task, in the unit used by xTaskCreate on the platform, which defaults to EEPROM_RTOS_WORKER_STACK.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos<eeprom>::setup(eeprom& storage, SemaphoreHandle_t mutex, const UBaseType_t worker_priority, const configSTACK_DEPTH_TYPE worker_stack) {
+
+    /* Ensure setup is only performed once */
+    if (m_storage != NULL) {
+        return -EBUSY;
+    }
+
+    /* Create mutex, queue and events */
+    m_mutex = (mutex != NULL) ? mutex : xSemaphoreCreateMutex();
+    if (m_mutex == NULL) {
+        return -ENOMEM;
+    }
+    m_queue = xQueueCreate(4, sizeof(struct request));
+    if (m_queue == NULL) {
+        return -ENOMEM;
+    }
+    m_events = xEventGroupCreate();
+    if (m_events == NULL) {
+        return -ENOMEM;
+    }
+    xEventGroupSetBits(m_events, m_event_ready | m_event_idle);
+
+    /* Start worker */
+    m_storage = &storage;
+    if (xTaskCreate(worker, "eeprom", worker_stack, this, worker_priority, NULL) != pdPASS) {
+        m_storage = NULL;
+        return -ENOMEM;
+    }
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Gets the mutex guarding the bus, so that drivers of other devices of the same bus can take it too.
+ * @return The mutex.
+ */
+template <class eeprom>
+SemaphoreHandle_t eeprom_rtos<eeprom>::mutex(void) {
+    return m_mutex;
+}
+
+/**
+ * Reads bytes, once the device is out of its write cycle, and waiting for the write in progress only if it overlaps them.
+ * @param[in] address
+ * @param[out] data
+ * @param[in] length
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos<eeprom>::read(const uint32_t address, uint8_t* const data, const size_t length) {
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Take the bus once the device is ready and no write in progress overlaps the bytes to read */
+    for (;;) {
+        xEventGroupWaitBits(m_events, m_event_ready, pdFALSE, pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(m_mutex, portMAX_DELAY);
+        bool overlap = (m_active_length > 0 && address < m_active_address + m_active_length && m_active_address < address + length);
+        if (overlap == false && (xEventGroupGetBits(m_events) & m_event_ready) != 0) {
+            break;
+        }
+        xSemaphoreGive(m_mutex);
+        if (overlap == true) {
+            xEventGroupWaitBits(m_events, m_event_idle, pdFALSE, pdTRUE, portMAX_DELAY);
+        }
+    }
+
+    /* Read */
+    int res = m_storage->read(address, data, length);
+    xSemaphoreGive(m_mutex);
+    return res;
+}
+
+/**
+ * Writes bytes through the worker task, blocking the calling task until the write completes.
+ * @note The calling task is woken up with a task notification, which must not be used for anything else while it waits.
+ * @param[in] address
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos<eeprom>::write(const uint32_t address, const uint8_t* const data, const size_t length) {
+    int result = -EIO;
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Queue request and wait for its completion */
+    struct request request = {address, data, length, xTaskGetCurrentTaskHandle(), &result};
+    if (xQueueSend(m_queue, &request, portMAX_DELAY) != pdTRUE) {
+        return -EIO;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return result;
+}
+
+/**
+ * Performs queued writes one page at a time, releasing the bus during write cycles.
+ * @param[in] parameter A pointer to the eeprom_rtos object.
+ */
+template <class eeprom>
+void eeprom_rtos<eeprom>::worker(void* parameter) {
+    eeprom_rtos<eeprom>* self = static_cast<eeprom_rtos<eeprom>*>(parameter);
+    struct request request;
+    int res;
+
+    for (;;) {
+        if (xQueueReceive(self->m_queue, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        /* Start write */
+        xSemaphoreTake(self->m_mutex, portMAX_DELAY);
+        res = self->m_storage->write_async(request.address, request.data, request.length);
+        if (res == 0) {
+            self->m_active_address = request.address;
+            self->m_active_length = request.length;
+            xEventGroupClearBits(self->m_events, m_event_idle);
+            res = -EINPROGRESS;
+        }
+        xSemaphoreGive(self->m_mutex);
+
+        /* Send one page at a time, and sleep through its write cycle, during which readers are blocked too
+         * With a transport whose transfers don't block, a page still on the bus has no write cycle running yet, and is checked again a tick later */
+        while (res == -EINPROGRESS) {
+            xSemaphoreTake(self->m_mutex, portMAX_DELAY);
+            xEventGroupClearBits(self->m_events, m_event_ready);
+            res = self->m_storage->write_async_poll();
+            bool transferring = (res == -EINPROGRESS && self->m_storage->write_cycle_remaining() == 0);
+            if (res != -EINPROGRESS) {
+                self->m_active_length = 0;
+            }
+            xSemaphoreGive(self->m_mutex);
+            if (transferring == true) {
+                vTaskDelay(1);
+            } else {
+                self->worker_sleep();
+            }
+        }
+        xEventGroupSetBits(self->m_events, m_event_idle);
+
+        /* Wake up writer */
+        *request.result = res;
+        xTaskNotifyGive(request.task);
+    }
+}
+
+/**
+ * Sleeps until the write cycle of the last page sent is over, then lets the readers in.
+ * @note In the worst case, a write cycle shorter than a tick costs a full tick.
+ */
+template <class eeprom>
+void eeprom_rtos<eeprom>::worker_sleep(void) {
+    for (;;) {
+        xSemaphoreTake(m_mutex, portMAX_DELAY);
+        uint32_t remaining = m_storage->write_cycle_remaining();
+        xSemaphoreGive(m_mutex);
+        if (remaining == 0) {
+            break;
+        }
+        TickType_t ticks = pdMS_TO_TICKS((remaining + 999) / 1000);
+        vTaskDelay((ticks > 0) ? ticks : 1);
+    }
+    xEventGroupSetBits(m_events, m_event_ready);
+    taskYIELD();
+}
+
+/**
+ * Stream and print interfaces over a thread safe eeprom, with a read and write index of its own.
+ * @note Give each task its own cursor, rather than sharing the indexes of the eeprom object.
+ * @note Print output is collected in a page sized buffer and committed as a single write when a page boundary is crossed, when the write index is moved elsewhere, or when flush() is called.
+ * @tparam eeprom The type of the underlying storage, as given to eeprom_rtos.
+ */
+template <class eeprom>
+class eeprom_rtos_cursor : public Stream {
+
+   public:
+    int setup(eeprom_rtos<eeprom>& storage);
+
+    /* Inherited from the stream interface */
+    int available();
+    int read();
+    int peek();
+
+    /* Inherited from the print interface */
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    void flush();
+
+    /* Seek for stream and print interfaces */
+    uint32_t seek_read(uint32_t index);
+    uint32_t seek_write(uint32_t index);
+
+   protected:
+    eeprom_rtos<eeprom>* m_storage = NULL;
+    uint32_t m_index_read = 0;
+    uint32_t m_index_write = 0;
+    static constexpr uint32_t m_size_total = eeprom::size_total();
+    static constexpr uint16_t m_size_page = eeprom::size_page();
+    uint8_t m_write_buffer[eeprom::size_page()];
+    uint32_t m_write_buffer_address = 0;
+    size_t m_write_buffer_length = 0;
+    int write_buffer_commit(void);
+    int stream_fetch(uint8_t& data);
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom>
+constexpr uint32_t eeprom_rtos_cursor<eeprom>::m_size_total;
+template <class eeprom>
+constexpr uint16_t eeprom_rtos_cursor<eeprom>::m_size_page;
+
+/**
+ * Configures the cursor.
+ * @param[in] storage A reference to the thread safe eeprom to use.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::setup(eeprom_rtos<eeprom>& storage) {
+    m_storage = &storage;
+    m_index_read = 0;
+    m_index_write = 0;
+    m_write_buffer_length = 0;
+    return 0;
+}
+
+/**
+ * Gets the number of bytes available in the stream.
+ * @note Inherited from the stream interface
+ * @return The number of bytes between the read index and the end of the eeprom.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::available() {
+    if (m_index_read <= m_size_total) {
+        return (m_size_total - m_index_read > INT_MAX) ? INT_MAX : m_size_total - m_index_read;
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * Reads a byte and moves the read index forward.
+ * @note Inherited from the stream interface
+ * @return The byte read, or 0 in case of failure, as eeprom_i2c::read() does, the read index being left as it is.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::read() {
+    uint8_t data;
+    int res = stream_fetch(data);
+    if (res < 0) {
+        return 0;
+    } else {
+        m_index_read += res;
+        return data;
+    }
+}
+
+/**
+ * Reads a byte without moving the read index.
+ * @note Inherited from the stream interface
+ * @return The byte read, or 0 in case of failure, as eeprom_i2c::peek() does.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::peek() {
+    uint8_t data;
+    int res = stream_fetch(data);
+    if (res < 0) {
+        return 0;
+    } else {
+        return data;
+    }
+}
+
+/**
+ * Writes a byte at the write index.
+ * @note Inherited from the print interface
+ * @param[in] data
+ * @return The number of bytes written.
+ */
+template <class eeprom>
+size_t eeprom_rtos_cursor<eeprom>::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+/**
+ * Writes bytes at the write index.
+ * @note Inherited from the print interface
+ * @param[in] data
+ * @param[in] length
+ * @return The number of bytes written, or buffered for writing.
+ */
+template <class eeprom>
+size_t eeprom_rtos_cursor<eeprom>::write(const uint8_t* data, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+
+        /* Commit pending bytes if the new ones can't be appended to them */
+        if (m_write_buffer_length > 0 && (m_index_write != m_write_buffer_address + m_write_buffer_length || m_index_write % m_size_page == 0)) {
+            if (write_buffer_commit() < 0) return i;
+        }
+
+        /* Ensure setup has been performed and write index is valid */
+        if (m_storage == NULL || m_index_write >= m_size_total) {
+            return i;
+        }
+
+        /* Append as many bytes as possible without crossing a page boundary */
+        if (m_write_buffer_length == 0) {
+            m_write_buffer_address = m_index_write;
+        }
+        size_t length_chunk = m_size_page - (m_index_write % m_size_page);
+        if (length_chunk > length - i) {
+            length_chunk = length - i;
+        }
+        memcpy(&m_write_buffer[m_write_buffer_length], &data[i], length_chunk);
+        m_write_buffer_length += length_chunk;
+        m_index_write += length_chunk;
+        i += length_chunk;
+    }
+    return i;
+}
+
+/**
+ * Commits pending print output.
+ * @note Inherited from the print interface
+ */
+template <class eeprom>
+void eeprom_rtos_cursor<eeprom>::flush() {
+    write_buffer_commit();
+}
+
+/**
+ * Moves the read index.
+ * @param[in] index
+ * @return The new read index, or -1 if the index is invalid.
+ */
+template <class eeprom>
+uint32_t eeprom_rtos_cursor<eeprom>::seek_read(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_read = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+/**
+ * Moves the write index.
+ * @param[in] index
+ * @return The new write index, or -1 if the index is invalid.
+ */
+template <class eeprom>
+uint32_t eeprom_rtos_cursor<eeprom>::seek_write(uint32_t index) {
+    if (index < m_size_total) {
+        m_index_write = index;
+        return index;
+    } else {
+        return ((uint32_t)-1);
+    }
+}
+
+/**
+ * Retrieves the byte at the read index, from the pending print output when it is there.
+ * @param[out] data The byte read.
+ * @return The number of bytes read in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::stream_fetch(uint8_t& data) {
+    if (m_storage == NULL || m_index_read >= m_size_total) {
+        return -EINVAL;
+    }
+    if (m_index_read < m_write_buffer_address + m_write_buffer_length && m_index_read >= m_write_buffer_address) {
+        data = m_write_buffer[m_index_read - m_write_buffer_address];
+        return 1;
+    }
+    int res = m_storage->read(m_index_read, &data, 1);
+    if (res < 0 || res != 1) {
+        return (res < 0) ? res : -EIO;
+    }
+    return 1;
+}
+
+/**
+ * Writes pending print output as a single write.
+ * @note On failure, the bytes are kept so that the commit can be attempted again.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom>
+int eeprom_rtos_cursor<eeprom>::write_buffer_commit(void) {
+    if (m_write_buffer_length == 0) {
+        return 0;
+    }
+    int res = m_storage->write(m_write_buffer_address, m_write_buffer, m_write_buffer_length);
+    if (res < 0 || (size_t)res != m_write_buffer_length) {
+        return (res < 0) ? res : -EIO;
+    }
+    m_write_buffer_length = 0;
+    return 0;
+}
+
+#endif
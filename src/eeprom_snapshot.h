@@ -0,0 +1,193 @@
+#ifndef EEPROM_SNAPSHOT_H
+#define EEPROM_SNAPSHOT_H
+
+/* Arduino libraries */
+#include <Arduino.h>
+
+/* C/C++ libraries */
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Project code */
+#include "eeprom_crc.h"
+
+/**
+ * Incremental saves of a ram region, such as the state of an application, to a page aligned range of an eeprom.
+ * @note The region is cut into slices of a page minus two bytes, and each page of the eeprom holds a slice followed by its crc-16, so that a torn or corrupted page is detected by load().
+ * @note The crcs are also kept in ram, so that save() only writes the pages whose slice changed since the last save or load, as single page writes.
+ * @note A change that leaves the crc of a slice unchanged goes unnoticed, which is unlikely (1 in 65536) but possible. Call save_all() from time to time if this matters.
+ * @note Pages are written one after the other, so an interrupted save leaves a mix of old and new pages, a page torn by it failing its crc. Use eeprom_kv when saves must be atomic.
+ * @tparam eeprom The type of the underlying storage, such as eeprom_i2c or eeprom_i2c_bank.
+ * @tparam size The size of the ram region, in bytes, which sets the size of the ram table of crcs (2 bytes per page).
+ */
+template <class eeprom, size_t size>
+class eeprom_snapshot {
+
+   public:
+    int setup(eeprom& storage, const uint32_t address, void* const region);
+    int load(void);
+    int save(void);
+    int save_all(void);
+
+   protected:
+    static constexpr size_t m_size_page = eeprom::size_page();
+    static constexpr size_t m_size_slice = m_size_page - 2;  // Bytes of the region in a page, which ends with the crc of the slice
+    static constexpr size_t m_pages = (size + m_size_slice - 1) / m_size_slice;
+    eeprom* m_storage = NULL;
+    uint32_t m_address = 0;
+    uint8_t* m_region = NULL;
+    uint16_t m_crcs[m_pages];
+    bool m_crcs_valid = false;  // Whether the crcs match the content of the eeprom
+    size_t page_length(const size_t page);
+    uint16_t page_crc(const size_t page);
+    static_assert(size > 0, "The region must hold at least one byte");
+    static_assert(eeprom::size_page() > 2, "Pages must be able to hold a slice and its crc");
+};
+
+/* Definitions of the compile time constants, for when they are odr-used */
+template <class eeprom, size_t size>
+constexpr size_t eeprom_snapshot<eeprom, size>::m_size_page;
+template <class eeprom, size_t size>
+constexpr size_t eeprom_snapshot<eeprom, size>::m_size_slice;
+template <class eeprom, size_t size>
+constexpr size_t eeprom_snapshot<eeprom, size>::m_pages;
+
+/**
+ * Configures the snapshot.
+ * @note Call this from the Arduino setup function, after the eeprom has been setup, then call load() to restore the region, or save_all() to initialize the eeprom.
+ * @param[in] storage A reference to the eeprom to use.
+ * @param[in] address The start of the range used by the snapshot, aligned on a page, which spans one page per slice of the region.
+ * @param[in] region The ram region, of size bytes, which must remain valid for as long as the snapshot is used.
+ * @return 0 in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, size_t size>
+int eeprom_snapshot<eeprom, size>::setup(eeprom& storage, const uint32_t address, void* const region) {
+
+    /* Ensure parameters are valid */
+    if (region == NULL || address % m_size_page != 0 || address >= eeprom::size_total() || m_pages * m_size_page > eeprom::size_total() - address) {
+        return -EINVAL;
+    }
+    m_storage = &storage;
+    m_address = address;
+    m_region = (uint8_t*)region;
+
+    /* The content of the eeprom is unknown until the first load or save */
+    m_crcs_valid = false;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Restores the ram region from the eeprom, page by page, and checks each slice against its crc.
+ * @note The slice of a page that doesn't match its crc is left as it is in ram, and the rest of the region is still restored. The next save() then writes all pages.
+ * @return 0 in case of success, -EBADMSG if a page doesn't match its crc, or another negative error code otherwise.
+ */
+template <class eeprom, size_t size>
+int eeprom_snapshot<eeprom, size>::load(void) {
+    uint8_t page[m_size_page];
+    int res;
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Read each slice and its crc, and only restore the slices that match it */
+    m_crcs_valid = false;
+    bool valid = true;
+    for (size_t i = 0; i < m_pages; i++) {
+        size_t length_slice = page_length(i);
+        res = m_storage->read(m_address + i * m_size_page, page, length_slice + 2);
+        if (res < 0) return res;
+        if ((size_t)res != length_slice + 2) return -EIO;
+        uint16_t crc = eeprom_crc16(0xFFFF, page, length_slice);
+        if (crc != (((uint16_t)page[length_slice] << 0) | ((uint16_t)page[length_slice + 1] << 8))) {
+            valid = false;
+            continue;
+        }
+        memcpy(&m_region[i * m_size_slice], page, length_slice);
+        m_crcs[i] = crc;
+    }
+    if (valid == false) {
+        return -EBADMSG;
+    }
+
+    /* Remember what the eeprom holds */
+    m_crcs_valid = true;
+
+    /* Return success */
+    return 0;
+}
+
+/**
+ * Writes the pages of the ram region that changed since the last save or load.
+ * @note Until load() or save_all() has succeeded once, all pages are written.
+ * @return The number of pages written in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, size_t size>
+int eeprom_snapshot<eeprom, size>::save(void) {
+    uint8_t page[m_size_page];
+    int res;
+
+    /* Ensure setup has been performed */
+    if (m_storage == NULL) {
+        return -EINVAL;
+    }
+
+    /* Write the pages whose slice differs, along with its crc, and only remember the new crc once written */
+    int count = 0;
+    bool all = (m_crcs_valid == false);
+    for (size_t i = 0; i < m_pages; i++) {
+        uint16_t crc = page_crc(i);
+        if (all == false && crc == m_crcs[i]) {
+            continue;
+        }
+        size_t length_slice = page_length(i);
+        memcpy(page, &m_region[i * m_size_slice], length_slice);
+        page[length_slice] = (uint8_t)(crc >> 0);
+        page[length_slice + 1] = (uint8_t)(crc >> 8);
+        res = m_storage->write(m_address + i * m_size_page, page, length_slice + 2);
+        if (res < 0) return res;
+        if ((size_t)res != length_slice + 2) return -EIO;
+        m_crcs[i] = crc;
+        count++;
+    }
+    m_crcs_valid = true;
+
+    /* Return number of pages written */
+    return count;
+}
+
+/**
+ * Writes all pages of the ram region, whether they changed or not.
+ * @return The number of pages written in case of success, or a negative error code otherwise.
+ */
+template <class eeprom, size_t size>
+int eeprom_snapshot<eeprom, size>::save_all(void) {
+    m_crcs_valid = false;
+    return save();
+}
+
+/**
+ * Gets the number of bytes of the region in a page, which is less than a full slice for the last one when the size of the region isn't a multiple of the slice size.
+ * @param[in] page The index of the page.
+ * @return The number of bytes.
+ */
+template <class eeprom, size_t size>
+size_t eeprom_snapshot<eeprom, size>::page_length(const size_t page) {
+    return (page == m_pages - 1) ? size - page * m_size_slice : m_size_slice;
+}
+
+/**
+ * Computes the crc of the current content of the slice of the region held by a page.
+ * @param[in] page The index of the page.
+ * @return The crc.
+ */
+template <class eeprom, size_t size>
+uint16_t eeprom_snapshot<eeprom, size>::page_crc(const size_t page) {
+    return eeprom_crc16(0xFFFF, &m_region[page * m_size_slice], page_length(page));
+}
+
+#endif